@@ -0,0 +1,376 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+#ifndef ADJOINT_GRADIENT_HH
+#define ADJOINT_GRADIENT_HH
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dumux/common/parameters.hh>
+#include <dumux/common/properties.hh>
+#include <dumux/common/timeloop.hh>
+#include <dumux/discretization/elementsolution.hh>
+
+#include "forwardsensitivity.hh"
+
+/*!
+ * \file
+ * \ingroup Common
+ * \brief Gradient of the episode rootMS objective by the discrete adjoint.
+ */
+namespace Dumux {
+
+/*!
+ * \ingroup Common
+ * \brief Gradient of the calibration objective
+ *        \f$ f = \sqrt{\sum_e (r_e - t_e)^2} \f$ (recovery r and target t
+ *        at the end of the episodes with a target) with respect to stage
+ *        input values, by the discrete adjoint of the implicit Euler steps.
+ *
+ * The recovery is the time integral of the oil outflux q, so f depends
+ * on the solution of step n through \f$ w_n q(x_n, p) \f$, with
+ * \f$ w_n = 100 \Delta t_n/(V_{oil} f) \sum_{e \ge e(n)} (r_e - t_e) \f$.
+ * Backwards from the last step the adjoint solves
+ * \f[
+ *  J_n^T \lambda_n = w_n \frac{\partial q}{\partial x_n}
+ *   - \left(\frac{\partial R_{n+1}}{\partial x_n}\right)^T \lambda_{n+1},
+ *  \qquad
+ *  \frac{df}{dp} = \sum_n w_n \frac{\partial q}{\partial p}
+ *   - \lambda_n \cdot \frac{\partial R_n}{\partial p}.
+ * \f]
+ * \f$ J_n \f$ is assembled again at the solution of the step and
+ * transposed. The previous time level only enters the storage term, so
+ * \f$ \partial R_{n+1}/\partial x_n \f$ is block diagonal, its blocks are
+ * evaluated with one residual per primary variable. The parameter
+ * derivatives take one residual per parameter, \f$ \partial q/\partial x \f$
+ * is evaluated on the outlet elements only. Per step this is about the
+ * cost of a Newton iteration, independent of the number of parameters.
+ *
+ * The forward run keeps the previous solution, the step size and the
+ * episode state of every step (checkpoints in memory, without thinning).
+ * They take numSteps() times about numDofs*numEq*sizeof(Scalar) bytes
+ * (checkpointBytes()), e.g. 240 MB for 10^4 steps of 1000 dofs with one
+ * particle (3 equations). The parameters are given as
+ * Adjoint.Parameters = Stage.2.MatrixLambda ... (none: disabled), e.g. on
+ * the command line, Adjoint.Epsilon is the relative perturbation of the
+ * finite differences.
+ *
+ * Only the implicit Euler scheme is differentiated. The chemistry is not
+ * (neither the split step nor the reaction sources), so the driver
+ * refuses the adjoint when it is built with LSWI_CHEMISTRY.
+ */
+template <class TypeTag, class Assembler, class LinearSolver>
+class AdjointGradient {
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using Problem = GetPropType<TypeTag, Properties::Problem>;
+    using GridGeometry = GetPropType<TypeTag, Properties::GridGeometry>;
+    using GridVariables = GetPropType<TypeTag, Properties::GridVariables>;
+    using SolutionVector = GetPropType<TypeTag, Properties::SolutionVector>;
+    using JacobianMatrix = typename Assembler::JacobianMatrix;
+    using EpisodeState = typename Problem::EpisodeState;
+
+    static constexpr int numEq = GetPropType<TypeTag, Properties::ModelTraits>::numEq();
+
+    static constexpr bool enableGridVolVarsCache = getPropValue<TypeTag, Properties::EnableGridVolumeVariablesCache>();
+
+    // a checkpoint of the forward run
+    struct Step {
+        SolutionVector xOld;
+        Scalar time;
+        Scalar dt;
+        int stepIndex;
+        int episodeIdx;
+        EpisodeState episodeState;
+    };
+
+public:
+    using Parameter = StageParameter;
+
+    AdjointGradient(std::shared_ptr<Problem> problem,
+                    std::shared_ptr<const GridGeometry> gridGeometry,
+                    std::shared_ptr<GridVariables> gridVariables,
+                    LinearSolver& linearSolver,
+                    const std::string& paramGroup = "")
+    : problem_(problem)
+    , gridGeometry_(gridGeometry)
+    , gridVariables_(gridVariables)
+    , linearSolver_(linearSolver)
+    {
+        if (hasParamInGroup(paramGroup, "Adjoint.Parameters")) {
+            for (const auto& label : getParamFromGroup<std::vector<std::string>>(paramGroup, "Adjoint.Parameters"))
+                parameters_.push_back(parseStageParameter(label, "Adjoint.Parameters"));
+        }
+        epsilon_ = getParamFromGroup<Scalar>(paramGroup, "Adjoint.Epsilon", 1e-6);
+
+        for (const auto& p : parameters_) {
+            if (p.stage >= problem_->stageCount())
+                DUNE_THROW(Dumux::ParameterException, "Adjoint.Parameters: " << p.label
+                           << ", there are " << problem_->stageCount() << " stages");
+            // throws for values which are not read per episode
+            problem_->spatialParams().stageValue(p.stage, p.name);
+        }
+        errors_.assign(std::max(problem_->episodeCount(), 1), 0.0);
+        gradient_.assign(parameters_.size(), 0.0);
+        sumSquares_ = 0.0;
+
+        if (enabled()) {
+            // the step sizes of the checkpoints are set on a time loop of
+            // our own, the one of the forward run is finished
+            timeLoop_ = std::make_shared<TimeLoop<Scalar>>(0.0, 1.0, std::numeric_limits<Scalar>::max(), false);
+            assembler_ = std::make_shared<Assembler>(problem_, gridGeometry_, gridVariables_, timeLoop_);
+        }
+    }
+
+    //! Parameters have been given
+    bool enabled(void) const { return !parameters_.empty(); }
+
+    //! No gradient in this run (the runs of Sensitivity.Check).
+    void disable(void) { parameters_.clear(); }
+
+    std::size_t numParameters(void) const { return parameters_.size(); }
+
+    const Parameter& parameter(std::size_t j) const { return parameters_[j]; }
+
+    //! Number of checkpoints (time steps) of the forward run.
+    std::size_t numSteps(void) const { return steps_.size(); }
+
+    //! Memory of the checkpoints in bytes.
+    std::size_t checkpointBytes(void) const
+    {
+        std::size_t bytes = steps_.capacity()*sizeof(Step);
+        for (const auto& step : steps_)
+            bytes += step.xOld.capacity()*sizeof(typename SolutionVector::block_type);
+        return bytes;
+    }
+
+    /*!
+     * \brief Keep the checkpoint of a step of the forward run.
+     *
+     * Call after the Newton solver has converged, before the time loop
+     * is advanced.
+     *
+     * \param xOld The solution at the start of the step
+     * \param time The time at the start of the step
+     * \param dt The size of the step
+     * \param stepIndex The index of the step
+     * \param episodeIdx The episode of the step
+     */
+    void recordStep(const SolutionVector& xOld, Scalar time, Scalar dt, int stepIndex, int episodeIdx)
+    {
+        if (!enabled()) return;
+        steps_.push_back({xOld, time, dt, stepIndex, episodeIdx, problem_->episodeState()});
+    }
+
+    //! Add the error of an episode with a target to the objective.
+    void addEpisodeError(int episodeIdx, Scalar recovery, Scalar target)
+    {
+        errors_[episodeIdx] += recovery - target;
+        sumSquares_ += (recovery - target)*(recovery - target);
+    }
+
+    //! The objective rootMS.
+    Scalar objective(void) const { return std::sqrt(sumSquares_); }
+
+    //! Derivative of the objective with respect to parameter j (after compute()).
+    Scalar gradient(std::size_t j) const { return gradient_[j]; }
+
+    /*!
+     * \brief Solve the adjoint backwards over the checkpoints.
+     *
+     * \param x The solution at the end of the forward run
+     *
+     * The grid variables and the episode parameters are left at the state
+     * of the first step.
+     */
+    void compute(const SolutionVector& x)
+    {
+        gradient_.assign(parameters_.size(), 0.0);
+        const Scalar f = objective();
+        if (!enabled() || steps_.empty() || !(f > 0)) return;
+
+        // sum of the errors of the episode of the step and the later ones
+        std::vector<Scalar> laterErrors(errors_.size(), 0.0);
+        Scalar sum = 0.0;
+        for (int e = errors_.size()-1; e >= 0; e--) {
+            sum += errors_[e];
+            laterErrors[e] = sum;
+        }
+
+        auto& spatialParams = problem_->spatialParams();
+        const auto numDofs = gridGeometry_->numDofs();
+        SolutionVector lambda(numDofs), rhs(numDofs), previousTerm(numDofs);
+        SolutionVector dR(numDofs), xPerturbed(numDofs);
+        previousTerm = 0.0;
+        JacobianMatrix transposed;
+
+        for (int n = steps_.size()-1; n >= 0; n--) {
+            const auto& step = steps_[n];
+            const SolutionVector& xn = (n+1 < (int)steps_.size())? steps_[n+1].xOld : x;
+            const Scalar w = 100.0*step.dt/(problem_->initialOilVolume()*f)*laterErrors[step.episodeIdx];
+
+            // the state of the step
+            problem_->setEpisodeState(step.episodeState);
+            problem_->setTime(step.stepIndex, step.time, step.dt);
+            timeLoop_->setTime(step.time);
+            timeLoop_->setTimeStepSize(step.dt);
+            gridVariables_->init(xn, step.xOld);
+            assembler_->setPreviousSolution(step.xOld);
+            assembler_->assembleJacobianAndResidual(xn);
+            const SolutionVector residual = assembler_->residual();
+            transpose_(assembler_->jacobian(), transposed);
+
+            // J_n^T lambda_n = w_n dq/dx_n - (dR_{n+1}/dx_n)^T lambda_{n+1}
+            rhs = 0.0;
+            if (w != 0.0)
+                addOutfluxGradient_(xn, w, rhs);
+            rhs -= previousTerm;
+            lambda = 0.0;
+            if (!linearSolver_.solve(transposed, lambda, rhs))
+                DUNE_THROW(Dune::MathError, "Adjoint of step " << step.stepIndex << ": linear solver did not converge");
+
+            // w_n dq/dp - lambda_n . dR_n/dp
+            const Scalar outflux = problem_->oilOutflux(gridVariables_->curGridVolVars(), xn);
+            for (std::size_t j = 0; j < parameters_.size(); ++j) {
+                const auto& p = parameters_[j];
+                const Scalar value = spatialParams.stageValue(p.stage, p.name);
+                using std::abs;
+                const Scalar delta = epsilon_*((abs(value) > 0)? abs(value) : 1.0);
+
+                spatialParams.setStageValue(p.stage, p.name, value + delta);
+                gridVariables_->init(xn, step.xOld);
+                assembler_->assembleResidual(xn);
+                dR = assembler_->residual();
+                dR -= residual;
+                const Scalar dq = problem_->oilOutflux(gridVariables_->curGridVolVars(), xn) - outflux;
+                spatialParams.setStageValue(p.stage, p.name, value);
+
+                gradient_[j] += (w*dq - (lambda*dR))/delta;
+            }
+
+            // (dR_n/dx_{n-1})^T lambda_n for the step before, the blocks
+            // of dof i only depend on the previous solution of dof i
+            previousTerm = 0.0;
+            if (n == 0) break;
+            for (int pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                xPerturbed = step.xOld;
+                for (std::size_t i = 0; i < numDofs; ++i)
+                    xPerturbed[i][pvIdx] += epsilon_*(abs_(step.xOld[i][pvIdx]) + 1.0);
+                gridVariables_->init(xn, xPerturbed);
+                assembler_->setPreviousSolution(xPerturbed);
+                assembler_->assembleResidual(xn);
+                const auto& perturbedResidual = assembler_->residual();
+                for (std::size_t i = 0; i < numDofs; ++i) {
+                    const Scalar delta = xPerturbed[i][pvIdx] - step.xOld[i][pvIdx];
+                    for (int eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                        previousTerm[i][pvIdx] += lambda[i][eqIdx]
+                            *(perturbedResidual[i][eqIdx] - residual[i][eqIdx])/delta;
+                }
+            }
+            assembler_->setPreviousSolution(step.xOld);
+        }
+    }
+
+private:
+    static Scalar abs_(Scalar value)
+    { using std::abs; return abs(value); }
+
+    // rhs += w dq/dx, q only depends on the volume variables of the outlet
+    // elements. They are perturbed where elementOilOutflux() reads them,
+    // see volVarAccess_().
+    void addOutfluxGradient_(const SolutionVector& x, Scalar w, SolutionVector& rhs)
+    {
+        auto& gridVolVars = gridVariables_->curGridVolVars();
+        auto fvGeometry = localView(*gridGeometry_);
+        for (const auto& element : elements(gridGeometry_->gridView())) {
+            fvGeometry.bind(element);
+            if (!problem_->hasOutletFace(element, fvGeometry)) continue;
+
+            auto elemVolVars = localView(gridVolVars);
+            elemVolVars.bind(element, fvGeometry, x);
+            const Scalar outflux = problem_->elementOilOutflux(element, fvGeometry, elemVolVars);
+            auto elemSol = elementSolution(element, x, *gridGeometry_);
+
+            for (const auto& scv : scvs(fvGeometry)) {
+                auto& volVars = volVarAccess_(gridVolVars, elemVolVars, scv);
+                const auto origVolVars = volVars;
+                const auto localIdx = scv.indexInElement();
+                for (int pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                    const Scalar value = elemSol[localIdx][pvIdx];
+                    const Scalar delta = epsilon_*(abs_(value) + 1.0);
+                    elemSol[localIdx][pvIdx] = value + delta;
+                    volVars.update(elemSol, *problem_, element, scv);
+                    const Scalar perturbedOutflux = problem_->elementOilOutflux(element, fvGeometry, elemVolVars);
+                    rhs[scv.dofIndex()][pvIdx] += w*(perturbedOutflux - outflux)/delta;
+                    elemSol[localIdx][pvIdx] = value;
+                }
+                volVars = origVolVars;
+            }
+        }
+    }
+
+    // The volume variables of scv: the cached ones of the grid, or those
+    // of the element view without the cache (as the local assemblers).
+    template<class GridVolumeVariables, class ElementVolumeVariables, class SubControlVolume>
+    static auto& volVarAccess_(GridVolumeVariables& gridVolVars, ElementVolumeVariables& elemVolVars,
+                               const SubControlVolume& scv)
+    {
+        if constexpr (enableGridVolVarsCache)
+            return gridVolVars.volVars(scv);
+        else
+            return elemVolVars[scv];
+    }
+
+    // At = A^T, the pattern of the box and cell centered Jacobians is symmetric.
+    static void transpose_(const JacobianMatrix& A, JacobianMatrix& At)
+    {
+        At = A;
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                auto entry = At[col.index()].find(row.index());
+                if (entry == At[col.index()].end())
+                    DUNE_THROW(Dune::InvalidStateException, "The pattern of the Jacobian is not symmetric");
+                for (int i = 0; i < numEq; ++i)
+                    for (int k = 0; k < numEq; ++k)
+                        (*entry)[k][i] = (*col)[i][k];
+            }
+        }
+    }
+
+    std::shared_ptr<Problem> problem_;
+    std::shared_ptr<const GridGeometry> gridGeometry_;
+    std::shared_ptr<GridVariables> gridVariables_;
+    LinearSolver& linearSolver_;
+    std::shared_ptr<TimeLoop<Scalar>> timeLoop_;
+    std::shared_ptr<Assembler> assembler_;
+
+    std::vector<Parameter> parameters_;
+    Scalar epsilon_;
+    std::vector<Step> steps_;
+    std::vector<Scalar> errors_;
+    Scalar sumSquares_;
+    std::vector<Scalar> gradient_;
+};
+
+} // end namespace Dumux
+#endif
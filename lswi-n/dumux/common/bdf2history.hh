@@ -0,0 +1,198 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+#ifndef BDF2_HISTORY_HH
+#define BDF2_HISTORY_HH
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dumux/common/parameters.hh>
+
+/*!
+ * \file
+ * \ingroup Common
+ * \brief Time level history for a variable step BDF2 storage term.
+ */
+namespace Dumux {
+
+/*!
+ * \ingroup Common
+ * \brief Keeps the storage of the time level before the previous one and
+ *        the step sizes required by the variable step BDF2 scheme
+ *
+ * \f[
+ *  \frac{1}{\Delta t_{n+1}} \left( \frac{1+2\omega}{1+\omega} S^{n+1}
+ *   - (1+\omega) S^{n} + \frac{\omega^2}{1+\omega} S^{n-1} \right),
+ *  \qquad \omega = \frac{\Delta t_{n+1}}{\Delta t_n}
+ * \f]
+ *
+ * The storage \f$S^{n-1}\f$ is kept per degree of freedom (box scheme),
+ * the current and previous storage are evaluated by the local residual
+ * as for the implicit Euler scheme. Without history (first step, after an
+ * episode switch) the weights reduce to implicit Euler.
+ *
+ * The local error is estimated from the difference between the new
+ * solution and the quadratic extrapolation of the three previous time
+ * levels (Milne's device with the constant step factor 2/11), relative
+ * to reference magnitudes of the primary variables.
+ *
+ * The scheme is selected with TimeLoop.Scheme = BDF2 (default
+ * ImplicitEuler).
+ */
+template <class Scalar, class NumEqVector, class SolutionVector>
+class Bdf2History {
+public:
+    Bdf2History(const std::string& paramGroup = "")
+    {
+        const auto scheme = getParamFromGroup<std::string>(paramGroup, "TimeLoop.Scheme", "ImplicitEuler");
+        if (scheme == "BDF2")
+            enabled_ = true;
+        else if (scheme == "ImplicitEuler")
+            enabled_ = false;
+        else
+            DUNE_THROW(Dune::InvalidStateException, "Unknown TimeLoop.Scheme " << scheme
+                       << " (use ImplicitEuler or BDF2)");
+
+        tolerance_ = getParamFromGroup<Scalar>(paramGroup, "TimeLoop.Bdf2Tolerance", 1e-3);
+        safetyFactor_ = getParamFromGroup<Scalar>(paramGroup, "TimeLoop.Bdf2SafetyFactor", 0.9);
+        maxGrowth_ = getParamFromGroup<Scalar>(paramGroup, "TimeLoop.Bdf2MaxGrowth", 2.0);
+        minShrink_ = getParamFromGroup<Scalar>(paramGroup, "TimeLoop.Bdf2MinShrink", 0.2);
+        reset();
+    }
+
+    //! BDF2 has been selected
+    bool enabled(void) const { return enabled_; }
+
+    //! BDF2 weights are used for the next step (history is available)
+    bool active(void) const { return enabled_ && levels_ > 0; }
+
+    //! Forget the history, the next step is an implicit Euler step.
+    void reset(void){
+        levels_ = 0;
+        h1_ = h2_ = 0;
+    }
+
+    /*!
+     * \brief Weights of the new, the previous and the old storage for a
+     *        step of size dt.
+     */
+    std::array<Scalar, 3> weights(Scalar dt) const {
+        if (!active() || h1_ <= 0)
+            return {{1.0, 1.0, 0.0}};
+        const Scalar omega = dt/h1_;
+        return {{(1.0 + 2.0*omega)/(1.0 + omega), 1.0 + omega, omega*omega/(1.0 + omega)}};
+    }
+
+    //! Storage (times extrusion factor) of a dof at the old time level.
+    const NumEqVector& storage(std::size_t dofIdx) const {
+        return storage_[dofIdx];
+    }
+
+    /*!
+     * \brief Estimate the local error of the step from xOld to x.
+     *
+     * Returns a negative number if the history is too short.
+     */
+    template<class PrimaryVariables>
+    Scalar estimateError(const SolutionVector& x, const SolutionVector& xOld,
+                         Scalar dt, const PrimaryVariables& reference) const {
+        if (!enabled_ || levels_ < 2 || h1_ <= 0 || h2_ <= 0) return -1.0;
+
+        // Lagrange weights of t_n, t_{n-1} and t_{n-2} at t_{n+1}
+        const Scalar h = dt;
+        const Scalar l0 = (h + h1_)*(h + h1_ + h2_)/(h1_*(h1_ + h2_));
+        const Scalar l1 = -h*(h + h1_ + h2_)/(h1_*h2_);
+        const Scalar l2 = h*(h + h1_)/((h1_ + h2_)*h2_);
+
+        Scalar error = 0;
+        for (std::size_t dofIdx = 0; dofIdx < x.size(); ++dofIdx) {
+            for (int pvIdx = 0; pvIdx < x[dofIdx].size(); ++pvIdx) {
+                const Scalar predicted = l0*xOld[dofIdx][pvIdx]
+                                       + l1*x1_[dofIdx][pvIdx]
+                                       + l2*x2_[dofIdx][pvIdx];
+                const Scalar scale = std::max(std::abs(reference[pvIdx]), std::abs(x[dofIdx][pvIdx]));
+                error = std::max(error, std::abs(x[dofIdx][pvIdx] - predicted)/scale);
+            }
+        }
+        return 2.0/11.0*error;
+    }
+
+    /*!
+     * \brief Step size suggested by the error estimate of the last step
+     *        (returns dt unchanged if there is no estimate).
+     */
+    Scalar suggestTimeStepSize(Scalar dt, Scalar error) const {
+        if (error < 0) return dt;
+        if (error == 0) return maxGrowth_*dt;
+        Scalar factor = safetyFactor_*std::cbrt(tolerance_/error);
+        return dt*std::min(maxGrowth_, std::max(minShrink_, factor));
+    }
+
+    /*!
+     * \brief Shift the time levels after a step of size dt has been accepted.
+     *
+     * Must be called before xOld is overwritten with the new solution:
+     * the storage of xOld (evaluated with the previous grid volume
+     * variables) becomes the old storage of the next step.
+     */
+    template<class Problem, class GridVariables, class LocalResidual>
+    void advance(const Problem& problem, const GridVariables& gridVariables,
+                 const LocalResidual& localResidual, const SolutionVector& xOld, Scalar dt){
+        if (!enabled_) return;
+
+        const auto& gridGeometry = problem.fvGridGeometry();
+        storage_.resize(gridGeometry.numDofs());
+        for (const auto& element : elements(gridGeometry.gridView())) {
+            auto fvGeometry = localView(gridGeometry);
+            auto elemVolVars = localView(gridVariables.prevGridVolVars());
+            fvGeometry.bindElement(element);
+            elemVolVars.bindElement(element, fvGeometry, xOld);
+            for (const auto& scv : scvs(fvGeometry)) {
+                const auto& volVars = elemVolVars[scv];
+                storage_[scv.dofIndex()] = localResidual.computeStorage(problem, scv, volVars);
+                storage_[scv.dofIndex()] *= volVars.extrusionFactor();
+            }
+        }
+
+        x2_ = x1_;
+        x1_ = xOld;
+        h2_ = h1_;
+        h1_ = dt;
+        levels_ = std::min(levels_ + 1, 2);
+    }
+
+private:
+    bool enabled_;
+    Scalar tolerance_;
+    Scalar safetyFactor_;
+    Scalar maxGrowth_;
+    Scalar minShrink_;
+
+    int levels_;
+    Scalar h1_, h2_;
+    std::vector<NumEqVector> storage_;
+    SolutionVector x1_, x2_;
+};
+
+} // end namespace Dumux
+#endif
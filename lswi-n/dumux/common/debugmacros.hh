@@ -0,0 +1,54 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+#ifndef DEBUG_MACROS_HH
+#define DEBUG_MACROS_HH
+
+#include <cstdio>
+
+/*!
+ * \file
+ * \ingroup Common
+ * \brief Convenience debug/warning/trace preprocessor macros.
+ *
+ * Used mainly for debugging. TRACE is extremely verbose and off
+ * by default. DBG is on by default. WARN is an execution warning (not
+ * used too often). To turn off, use -DNODEBUG and -DNOWARN in CXXFLAGS
+ * or from CMakeLists.txt specifications. Each macro is a single
+ * statement, safe in unbraced loops and if/else.
+ */
+// TRACE:
+#undef TRACE
+#define TRACE(...)  do { } while (0)
+//#define TRACE(...)  do {fprintf(stderr, "TRACE> "); fprintf(stderr, __VA_ARGS__);} while (0)
+// DBG:
+#undef DBG
+#ifndef NODEBUG
+# define DBG(...)  do {fprintf(stderr, "DBG> "); fprintf(stderr, __VA_ARGS__);} while (0)
+#else
+# define DBG(...)  do { } while (0)
+#endif
+// WARN:
+#undef WARN
+#ifndef NOWARN
+# define WARN(...)  do {fprintf(stderr, "warning> "); fprintf(stderr, __VA_ARGS__);} while (0)
+#else
+# define WARN(...)  do { } while (0)
+#endif
+
+#endif
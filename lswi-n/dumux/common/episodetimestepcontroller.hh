@@ -0,0 +1,217 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+#ifndef EPISODE_TIME_STEP_CONTROLLER_HH
+#define EPISODE_TIME_STEP_CONTROLLER_HH
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include <dumux/common/parameters.hh>
+
+/*!
+ * \file
+ * \ingroup Common
+ * \brief Time step control aware of episode boundaries.
+ */
+namespace Dumux {
+
+/*!
+ * \ingroup Common
+ * \brief Time step controller for sequences of episodes.
+ *
+ * The controller combines the Newton suggestion with
+ *  - a restart at every episode switch from the history of the previous
+ *    episode (a fraction of its last step, never below DtInitial) and a
+ *    bounded growth factor per step, never more than the growth factor
+ *    above the Newton suggestion and never above a Newton request to
+ *    shrink the step,
+ *  - a limit from the speed of the inlet salinity front, as long as the
+ *    front of the current episode is inside the domain,
+ *  - the largest allowed step once the production rate is steady and
+ *    the front has left the domain,
+ *  - a final adjustment so that the remaining time to the end of the
+ *    episode is divided into steps of equal size (no sliver step).
+ *
+ * The front limit and MaxTimeStepSize are applied last, they also bound
+ * DtInitial.
+ *
+ * Parameters are read from the TimeLoop group, the controller is enabled
+ * with TimeLoop.UseEpisodeController.
+ */
+template <class Scalar>
+class EpisodeTimeStepController {
+public:
+    EpisodeTimeStepController(const std::string& paramGroup = "")
+    {
+        enabled_ = getParamFromGroup<bool>(paramGroup, "TimeLoop.UseEpisodeController", false);
+        growthFactor_ = getParamFromGroup<Scalar>(paramGroup, "TimeLoop.MaxGrowthFactor", 2.0);
+        restartFraction_ = getParamFromGroup<Scalar>(paramGroup, "TimeLoop.RestartFraction", 0.1);
+        frontCourant_ = getParamFromGroup<Scalar>(paramGroup, "TimeLoop.FrontCourantNumber", 1.0);
+        steadyStateTolerance_ = getParamFromGroup<Scalar>(paramGroup, "TimeLoop.SteadyStateTolerance", 1e-3);
+        steadyStateRateFloor_ = getParamFromGroup<Scalar>(paramGroup, "TimeLoop.SteadyStateRateFloor", 1e-9);
+        steadyStateSteps_ = getParamFromGroup<int>(paramGroup, "TimeLoop.SteadyStateSteps", 5);
+
+        if (growthFactor_ < 1.0)
+            DUNE_THROW(Dune::InvalidStateException, "TimeLoop.MaxGrowthFactor must be >= 1");
+
+        lastDt_ = 0;
+        reset_();
+    }
+
+    bool enabled(void) const { return enabled_; }
+
+    /*!
+     * \brief Set the transport geometry: domain length and cell size in
+     *        flow direction (used for the salinity front limit).
+     */
+    void setGeometry(Scalar domainLength, Scalar cellSize){
+        domainLength_ = domainLength;
+        cellSize_ = cellSize;
+    }
+
+    /*!
+     * \brief Start a new episode and return its first time step size.
+     *
+     * \param time current time
+     * \param frontSpeed speed of the new inlet salinity front [m/s], or
+     *        zero if the inlet salinity did not change
+     * \param dtInitial the episode's DtInitial
+     * \param maxDt the episode's MaxTimeStepSize
+     */
+    Scalar beginEpisode(Scalar time, Scalar frontSpeed, Scalar dtInitial, Scalar maxDt){
+        reset_();
+        episodeStart_ = time;
+        frontSpeed_ = frontSpeed;
+        maxDt_ = maxDt;
+
+        Scalar dt = std::max(dtInitial, restartFraction_*lastDt_);
+        return std::min(dt, std::min(maxDt_, frontLimit_(time)));
+    }
+
+    /*!
+     * \brief Record an accepted time step.
+     *
+     * \param dt the size of the step
+     * \param recovery the cumulative recovery after the step
+     */
+    void stepAccepted(Scalar dt, Scalar recovery){
+        Scalar rate = (dt > 0)? (recovery - lastRecovery_)/dt : 0;
+        if (haveRate_ && std::abs(rate - lastRate_) <=
+                steadyStateTolerance_*std::max(std::abs(rate), steadyStateRateFloor_))
+            steadySteps_++;
+        else
+            steadySteps_ = 0;
+
+        haveRate_ = true;
+        lastRate_ = rate;
+        lastRecovery_ = recovery;
+        lastDt_ = dt;
+        steps_++;
+    }
+
+    //! Set the recovery at the beginning of the run (for restarts).
+    void setRecovery(Scalar recovery){
+        lastRecovery_ = recovery;
+    }
+
+    /*!
+     * \brief Suggest the size of the next time step.
+     *
+     * \param time the current time
+     * \param newtonDt the step size suggested by the Newton solver
+     * \param episodeEnd end time of the current episode
+     */
+    Scalar suggestTimeStepSize(Scalar time, Scalar newtonDt, Scalar episodeEnd) const {
+        Scalar dt;
+        if (steadyState(time)) {
+            // steady production: grow towards the largest allowed step,
+            // unless the Newton solver asks for a smaller one
+            dt = (newtonDt < lastDt_)? newtonDt : growthFactor_*lastDt_;
+        } else {
+            dt = std::min(newtonDt, growthFactor_*lastDt_);
+        }
+        dt = std::min(dt, std::min(maxDt_, frontLimit_(time)));
+        return evenlySpaced_(time, dt, episodeEnd);
+    }
+
+    //! Production rate is steady and the current front has left the domain.
+    bool steadyState(Scalar time) const {
+        return steadySteps_ >= steadyStateSteps_ && !frontInside_(time);
+    }
+
+    //! Accepted steps since the start of the episode
+    int steps(void) const { return steps_; }
+
+private:
+    void reset_(void){
+        steps_ = 0;
+        steadySteps_ = 0;
+        haveRate_ = false;
+        lastRate_ = 0;
+        frontSpeed_ = 0;
+        maxDt_ = std::numeric_limits<Scalar>::max();
+    }
+
+    bool frontInside_(Scalar time) const {
+        if (frontSpeed_ <= 0 || domainLength_ <= 0) return false;
+        return frontSpeed_*(time - episodeStart_) < domainLength_;
+    }
+
+    // The front may travel FrontCourantNumber cells per step.
+    Scalar frontLimit_(Scalar time) const {
+        if (frontCourant_ <= 0 || cellSize_ <= 0 || !frontInside_(time))
+            return std::numeric_limits<Scalar>::max();
+        return frontCourant_*cellSize_/frontSpeed_;
+    }
+
+    // Divide the remaining time of the episode into equal steps no
+    // larger than dt.
+    Scalar evenlySpaced_(Scalar time, Scalar dt, Scalar episodeEnd) const {
+        Scalar remaining = episodeEnd - time;
+        if (remaining <= 0 || dt <= 0 || remaining > 1e6*dt) return dt;
+        Scalar n = std::ceil(remaining/dt - 1e-6);
+        return remaining/std::max(n, Scalar(1));
+    }
+
+    bool enabled_;
+    Scalar growthFactor_;
+    Scalar restartFraction_;
+    Scalar frontCourant_;
+    Scalar steadyStateTolerance_;
+    Scalar steadyStateRateFloor_;
+    int steadyStateSteps_;
+
+    Scalar domainLength_ = 0;
+    Scalar cellSize_ = 0;
+
+    Scalar episodeStart_ = 0;
+    Scalar frontSpeed_;
+    Scalar maxDt_;
+    Scalar lastDt_;
+    Scalar lastRate_;
+    Scalar lastRecovery_ = 0;
+    bool haveRate_;
+    int steps_;
+    int steadySteps_;
+};
+
+} // end namespace Dumux
+#endif
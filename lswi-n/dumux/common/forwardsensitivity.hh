@@ -0,0 +1,230 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+#ifndef FORWARD_SENSITIVITY_HH
+#define FORWARD_SENSITIVITY_HH
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dumux/common/parameters.hh>
+#include <dumux/common/properties.hh>
+
+/*!
+ * \file
+ * \ingroup Common
+ * \brief Sensitivities of the oil recovery with respect to stage input
+ *        values (tangent-linear model).
+ */
+namespace Dumux {
+
+//! A stage input value Stage.<stage+1>.<name> as a parameter of the recovery.
+struct StageParameter {
+    std::string label;
+    int stage;
+    std::string name;
+};
+
+//! The stage parameter of a label Stage.<k>.<name> (key: the list it came from).
+inline StageParameter parseStageParameter(const std::string& label, const std::string& key)
+{
+    const std::string prefix = "Stage.";
+    const auto dot = label.find('.', prefix.size());
+    char *end = nullptr;
+    const long stage = std::strtol(label.c_str() + prefix.size(), &end, 10);
+    if (label.compare(0, prefix.size(), prefix) != 0 || dot == std::string::npos
+        || end != label.c_str() + dot || stage < 1)
+        DUNE_THROW(Dumux::ParameterException, key << ": " << label
+                   << " is not of the form Stage.<k>.<name>");
+    return {label, (int)stage - 1, label.substr(dot + 1)};
+}
+
+/*!
+ * \ingroup Common
+ * \brief Forward sensitivities \f$ s = \partial x / \partial p \f$ of the
+ *        solution and of the oil recovery along the time steps.
+ *
+ * Every implicit Euler step solves \f$ R(x_n, x_{n-1}, p) = 0 \f$, the
+ * sensitivities of a parameter p follow from
+ * \f[
+ *  J_n s_n = - \frac{\partial R}{\partial x_{n-1}} s_{n-1}
+ *            - \frac{\partial R}{\partial p},
+ *  \qquad J_n = \frac{\partial R}{\partial x_n},
+ * \f]
+ * with the Jacobian assembled at the solution of the step. The right hand
+ * side is the derivative of the residual in the direction
+ * \f$ (s_{n-1}, 1) \f$ of \f$ (x_{n-1}, p) \f$, one residual evaluation
+ * per parameter. The recovery is the time integral of the oil outflux
+ * \f$ q(x, p) \f$, its sensitivity is accumulated with the derivative of q
+ * in the direction \f$ (s_n, 1) \f$. Per step this costs one Jacobian, and
+ * per parameter one residual, one linear solve and two updates of the
+ * volume variables.
+ *
+ * The parameters are the stage input values read by the spatial
+ * parameters per episode, Sensitivity.Parameters = Stage.2.MatrixLambda
+ * Stage.2.MatrixSnr ... (none: disabled). The relative perturbation of the
+ * directional derivatives is Sensitivity.Epsilon.
+ *
+ * Only the implicit Euler scheme is differentiated, reaction sources
+ * (Chemistry.Coupling) are taken as given. The sensitivities start from
+ * zero at the start time (also at a restart).
+ *
+ * With Sensitivity.Check the driver compares the result with the central
+ * finite difference of two full runs per parameter (see runSimulation()).
+ */
+template <class TypeTag, class Assembler, class LinearSolver>
+class ForwardSensitivity {
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using Problem = GetPropType<TypeTag, Properties::Problem>;
+    using GridVariables = GetPropType<TypeTag, Properties::GridVariables>;
+    using SolutionVector = GetPropType<TypeTag, Properties::SolutionVector>;
+
+public:
+    using Parameter = StageParameter;
+
+    ForwardSensitivity(Problem& problem, GridVariables& gridVariables,
+                       Assembler& assembler, LinearSolver& linearSolver,
+                       const std::string& paramGroup = "")
+    : problem_(problem)
+    , gridVariables_(gridVariables)
+    , assembler_(assembler)
+    , linearSolver_(linearSolver)
+    {
+        if (hasParamInGroup(paramGroup, "Sensitivity.Parameters")) {
+            for (const auto& label : getParamFromGroup<std::vector<std::string>>(paramGroup, "Sensitivity.Parameters"))
+                parameters_.push_back(parseStageParameter(label, "Sensitivity.Parameters"));
+        }
+        epsilon_ = getParamFromGroup<Scalar>(paramGroup, "Sensitivity.Epsilon", 1e-6);
+
+        for (const auto& p : parameters_) {
+            if (p.stage >= problem_.stageCount())
+                DUNE_THROW(Dumux::ParameterException, "Sensitivity.Parameters: " << p.label
+                           << ", there are " << problem_.stageCount() << " stages");
+            // throws for values which are not read per episode
+            problem_.spatialParams().stageValue(p.stage, p.name);
+        }
+
+        sensitivity_.resize(parameters_.size());
+        for (auto& s : sensitivity_) {
+            s.resize(problem_.fvGridGeometry().numDofs());
+            s = 0.0;
+        }
+        recovery_.assign(parameters_.size(), 0.0);
+        objective_.assign(parameters_.size(), 0.0);
+    }
+
+    //! Parameters have been given
+    bool enabled(void) const { return !parameters_.empty(); }
+
+    //! No sensitivities in this run (the runs of Sensitivity.Check).
+    void disable(void) { parameters_.clear(); }
+
+    std::size_t numParameters(void) const { return parameters_.size(); }
+
+    const Parameter& parameter(std::size_t j) const { return parameters_[j]; }
+
+    //! Derivative of the recovery (in percent) with respect to parameter j.
+    Scalar recovery(std::size_t j) const { return recovery_[j]; }
+
+    /*!
+     * \brief Advance the sensitivities over the step from xOld to x.
+     *
+     * Call after the Newton solver has converged, before the time loop
+     * and the solutions are advanced: the grid variables, the previous
+     * solution of the assembler and the time step size are the ones of
+     * the step. They are the same on return.
+     */
+    void step(const SolutionVector& x, const SolutionVector& xOld, Scalar dt)
+    {
+        if (!enabled()) return;
+        auto& spatialParams = problem_.spatialParams();
+
+        // Jacobian, residual and outflux at the solution of the step
+        assembler_.assembleJacobianAndResidual(x);
+        const SolutionVector residual = assembler_.residual();
+        const Scalar outflux = problem_.oilOutflux(gridVariables_.curGridVolVars(), x);
+
+        SolutionVector rhs(residual), xPerturbed(x), s(x);
+        for (std::size_t j = 0; j < parameters_.size(); ++j) {
+            const auto& p = parameters_[j];
+            const Scalar value = spatialParams.stageValue(p.stage, p.name);
+            using std::abs;
+            const Scalar delta = epsilon_*((abs(value) > 0)? abs(value) : 1.0);
+
+            // rhs = -(dR/dx_{n-1} s_{n-1} + dR/dp)
+            xPerturbed = xOld;
+            xPerturbed.axpy(delta, sensitivity_[j]);
+            spatialParams.setStageValue(p.stage, p.name, value + delta);
+            gridVariables_.init(x, xPerturbed);
+            assembler_.setPreviousSolution(xPerturbed);
+            assembler_.assembleResidual(x);
+            rhs = residual;
+            rhs -= assembler_.residual();
+            rhs /= delta;
+
+            s = 0.0;
+            if (!linearSolver_.solve(assembler_.jacobian(), s, rhs))
+                DUNE_THROW(Dune::MathError, "Sensitivity of " << p.label << ": linear solver did not converge");
+
+            // dq/dx s_n + dq/dp
+            xPerturbed = x;
+            xPerturbed.axpy(delta, s);
+            gridVariables_.update(xPerturbed);
+            const Scalar perturbedOutflux = problem_.oilOutflux(gridVariables_.curGridVolVars(), xPerturbed);
+            spatialParams.setStageValue(p.stage, p.name, value);
+
+            recovery_[j] += 100.0/problem_.initialOilVolume()*dt*(perturbedOutflux - outflux)/delta;
+            sensitivity_[j] = s;
+        }
+
+        gridVariables_.init(x, xOld);
+        assembler_.setPreviousSolution(xOld);
+    }
+
+    /*!
+     * \brief Add the error of an episode with a target to the objective
+     *        rootMS = sqrt(sum of the squared episode errors).
+     */
+    void addEpisodeError(Scalar recovery, Scalar target)
+    {
+        for (std::size_t j = 0; j < parameters_.size(); ++j)
+            objective_[j] += (recovery - target)*recovery_[j];
+    }
+
+    //! Derivative of rootMS with respect to parameter j.
+    Scalar rootMSGradient(std::size_t j, Scalar rootMS) const
+    { return (rootMS > 0)? objective_[j]/rootMS : 0.0; }
+
+private:
+    Problem& problem_;
+    GridVariables& gridVariables_;
+    Assembler& assembler_;
+    LinearSolver& linearSolver_;
+
+    std::vector<Parameter> parameters_;
+    Scalar epsilon_;
+    std::vector<SolutionVector> sensitivity_;
+    std::vector<Scalar> recovery_;
+    std::vector<Scalar> objective_;
+};
+
+} // end namespace Dumux
+#endif
@@ -14,13 +14,13 @@ template <class Scalar>
 class ClAnion : public Base<Scalar, ClAnion<Scalar> >
 {
 public:
-    static bool isAcid(void){ return false;}
-    static bool isSalt(void){ return false;}
-    static int valence(void){return -1;}
-    static Scalar a(void){return 3.5e-10;}
-    static Scalar b(void){return 0.015;}
+    static constexpr bool isAcid(void){ return false;}
+    static constexpr bool isSalt(void){ return false;}
+    static constexpr int valence(void){return -1;}
+    static constexpr Scalar a(void){return 3.5e-10;}
+    static constexpr Scalar b(void){return 0.015;}
     static std::string name() { return "Cl-"; }
-    static Scalar molarMass() { return 35.453e-3 ; }
+    static constexpr Scalar molarMass() { return 35.453e-3 ; }
     /*!
      * \brief The ionic radius in \f$\mathrm{[m]}\f$.
      * this is a bit tricky. Bicarbonate ion has 3 oxygen atoms
@@ -28,7 +28,7 @@ public:
      * in covalent bond, 
      * C=77 pm, O=73 pm H=38. 77+73+38=188 pm
      */
-    static Scalar ionicRadius() { return 181-12 ; }
+    static constexpr Scalar ionicRadius() { return 181-12 ; }
 };
 
 } // end namespace
@@ -52,13 +52,13 @@ template <class Scalar>
 class CO3Anion : public Base<Scalar, CO3Anion<Scalar> >
 {
 public:
-    static bool isAcid(void){ return false;}
-    static bool isSalt(void){ return false;}
-    static int valence(void){return -2;}
-    static Scalar a(void){return 5.4e-10;}
-    static Scalar b(void){return 0;}
+    static constexpr bool isAcid(void){ return false;}
+    static constexpr bool isSalt(void){ return false;}
+    static constexpr int valence(void){return -2;}
+    static constexpr Scalar a(void){return 5.4e-10;}
+    static constexpr Scalar b(void){return 0;}
     static std::string name() { return "CO3--"; }
-    static Scalar molarMass() { return 60.015e-3 ; }
+    static constexpr Scalar molarMass() { return 60.015e-3 ; }
     /*!
      * \brief The ionic radius in \f$\mathrm{[m]}\f$.
      * this is a bit tricky. Bicarbonate ion has 3 oxygen atoms
@@ -66,7 +66,7 @@ public:
      * in covalent bond, XXX this is probably wrong
      * C=77 pm, O=73 pm H=38. 77+73+38=188 pm
      */
-    static Scalar ionicRadius() { return 188-12 ; }
+    static constexpr Scalar ionicRadius() { return 188-12 ; }
 };
 
 } // end namespace
@@ -90,13 +90,13 @@ template <class Scalar>
 class HCO3Anion : public Base<Scalar, HCO3Anion<Scalar> >
 {
 public:
-    static bool isAcid(void){ return false;}
-    static bool isSalt(void){ return false;}
-    static int valence(void){return -1;}
-    static Scalar a(void){return 5.4e-10;}
-    static Scalar b(void){return 0;}
+    static constexpr bool isAcid(void){ return false;}
+    static constexpr bool isSalt(void){ return false;}
+    static constexpr int valence(void){return -1;}
+    static constexpr Scalar a(void){return 5.4e-10;}
+    static constexpr Scalar b(void){return 0;}
     static std::string name() { return "HCO3-"; }
-    static Scalar molarMass() { return 61.016e-3 ; }
+    static constexpr Scalar molarMass() { return 61.016e-3 ; }
 };
 
 } // end namespace
@@ -120,13 +120,13 @@ template <class Scalar>
 class NaSO4Anion : public Base<Scalar, NaSO4Anion<Scalar> >
 {
 public:
-    static bool isAcid(void){ return false;}
-    static bool isSalt(void){ return true;}
-    static int valence(void){return -1;}
-    static Scalar a(void){return 5.4e-10;}
-    static Scalar b(void){return 0;}
+    static constexpr bool isAcid(void){ return false;}
+    static constexpr bool isSalt(void){ return true;}
+    static constexpr int valence(void){return -1;}
+    static constexpr Scalar a(void){return 5.4e-10;}
+    static constexpr Scalar b(void){return 0;}
     static std::string name() { return "NaSO4-"; }
-    static Scalar molarMass() { return 22.990e-3 + 96.062e-3; }
+    static constexpr Scalar molarMass() { return 22.990e-3 + 96.062e-3; }
 };
 
 } // end namespace
@@ -150,13 +150,13 @@ template <class Scalar>
 class OHAnion : public Base<Scalar, OHAnion<Scalar> >
 {
 public:
-    static bool isAcid(void){ return false;}
-    static bool isSalt(void){ return false;}
-    static int valence(void){return -1;}
-    static Scalar a(void){return 10.65e-10;}
-    static Scalar b(void){return 0.21;}
+    static constexpr bool isAcid(void){ return false;}
+    static constexpr bool isSalt(void){ return false;}
+    static constexpr int valence(void){return -1;}
+    static constexpr Scalar a(void){return 10.65e-10;}
+    static constexpr Scalar b(void){return 0.21;}
     static std::string name() { return "OH-"; }
-    static Scalar molarMass() { return 17.007e-3 ; }
+    static constexpr Scalar molarMass() { return 17.007e-3 ; }
 };
 
 } // end namespace
@@ -180,13 +180,13 @@ template <class Scalar>
 class SO4Anion : public Base<Scalar, SO4Anion<Scalar> >
 {
 public:
-    static bool isAcid(void){ return false;}
-    static bool isSalt(void){ return false;}
-    static int valence(void){return -2;}
-    static Scalar a(void){return 5e-10;}
-    static Scalar b(void){return -0.04;}
+    static constexpr bool isAcid(void){ return false;}
+    static constexpr bool isSalt(void){ return false;}
+    static constexpr int valence(void){return -2;}
+    static constexpr Scalar a(void){return 5e-10;}
+    static constexpr Scalar b(void){return -0.04;}
     static std::string name() { return "SO4--"; }
-    static Scalar molarMass() { return 96.062e-3 ; }
+    static constexpr Scalar molarMass() { return 96.062e-3 ; }
     /*!
      * \brief The ionic radius in \f$\mathrm{[m]}\f$.
      * this is a bit tricky. Sulfate ion has 4 oxygen atoms
@@ -195,7 +195,7 @@ public:
      * The longest axis would be O-S-O. Covalent radius for 
      * S=102 pm, O=73 pm. 102+2*73 = 248 pm 
      * this is probably off    */
-    static Scalar ionicRadius() { return 248e-12 ; }
+    static constexpr Scalar ionicRadius() { return 248e-12 ; }
 };
 } // end namespace
 } // end namespace
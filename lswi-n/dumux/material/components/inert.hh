@@ -14,14 +14,14 @@ template <class Scalar>
 class CaSO4suspended : public Base<Scalar, CaSO4suspended<Scalar> >
 {
 public:
-    static bool isAcid(void){ return false;}
-    static bool isSalt(void){ return true;}
-    static int valence(void){return 0;}
-    static Scalar a(void){return 3;}
-    static Scalar b(void){return 0;}
+    static constexpr bool isAcid(void){ return false;}
+    static constexpr bool isSalt(void){ return true;}
+    static constexpr int valence(void){return 0;}
+    static constexpr Scalar a(void){return 3;}
+    static constexpr Scalar b(void){return 0;}
     static std::string name() { return "CaSO4"; }
-    static Scalar molarMass() { return 40.078e-3 + 96.062e-3; }
-    static Scalar ionicRadius() { return 100e-12 ; }
+    static constexpr Scalar molarMass() { return 40.078e-3 + 96.062e-3; }
+    static constexpr Scalar ionicRadius() { return 100e-12 ; }
 };
 
 } // end namespace
@@ -45,14 +45,14 @@ template <class Scalar>
 class MgSO4 : public Base<Scalar, MgSO4<Scalar> >
 {
 public:
-    static bool isAcid(void){ return false;}
-    static bool isSalt(void){ return true;}
-    static int valence(void){return 0;}
-    static Scalar a(void){return 3;}
-    static Scalar b(void){return 0;}
+    static constexpr bool isAcid(void){ return false;}
+    static constexpr bool isSalt(void){ return true;}
+    static constexpr int valence(void){return 0;}
+    static constexpr Scalar a(void){return 3;}
+    static constexpr Scalar b(void){return 0;}
     static std::string name() { return "MgSO4"; }
-    static Scalar molarMass() { return 24.3e-3 + 96.062e-3; }
-    static Scalar ionicRadius() { return 100e-12 ; }
+    static constexpr Scalar molarMass() { return 24.3e-3 + 96.062e-3; }
+    static constexpr Scalar ionicRadius() { return 100e-12 ; }
 };
 
 } // end namespace
@@ -55,6 +55,12 @@ namespace Dumux
  *        - the actual material laws (linear, VanGenuchten...) do not need to deal with any kind of conversion
  *        - the definition of the material law in the spatial parameters is not really intuitive, but using it is:
  *          Hand in values, get back values, do not deal with conversion.
+ *
+ *        pc, krw and krn are evaluated by the kernels for the SalinityMode of
+ *        the params, looked up in a table of function pointers: the salinity
+ *        mode is fixed for an episode, so the LS() == HS() tests are not
+ *        repeated for every call. The derivatives and inverses, which the
+ *        model does not use, keep testing it.
  */
 template <class EffLawT, class AbsParamsT = EffToAbsLawParams<typename EffLawT::Params> >
 class EffToAbsLaw
@@ -77,7 +83,7 @@ public:
      */
     static Scalar pc(const Params &params, Scalar sw)
     {
-        return EffLaw::pc(params, swToSwe(params, sw));
+        return kernels_[static_cast<int>(params.salinityMode())].pc(params, sw);
     }
 
     /*!
@@ -162,7 +168,7 @@ public:
      */
     static Scalar krw(const Params &params, Scalar sw)
     {
-        return EffLaw::krw(params, swToSwe(params, sw));
+        return kernels_[static_cast<int>(params.salinityMode())].krw(params, sw);
     }
 
     /*!
@@ -191,7 +197,7 @@ public:
      */
     static Scalar krn(const Params &params, Scalar sw)
     {
-        return EffLaw::krn(params, swToSwe(params, sw));
+        return kernels_[static_cast<int>(params.salinityMode())].krn(params, sw);
     }
 
     /*!
@@ -216,10 +222,11 @@ public:
      *                  and then the params container is constructed accordingly. Afterwards the values are set there, too.
      * \return Effective saturation of the wetting phase.
      */
+    template<SalinityMode mode = SalinityMode::interpolated>
     static Scalar swToSwe(const Params &params, Scalar sw)
     {
         const Scalar swToSwe_HS = (sw - params.swr_HS())/(1. - params.swr_HS() - params.snr_HS());
-        if (params.LS() == params.HS())
+        if (mode == SalinityMode::constant || params.LS() == params.HS())
         {
             return swToSwe_HS;
         }
@@ -255,6 +262,29 @@ public:
         //return (sw - params.swr())/(1. - params.swr() - params.snr());
     }
 private:
+    // pc, krw and krn for one salinity mode
+    struct Kernels
+    {
+        Scalar (*pc)(const Params &params, Scalar sw);
+        Scalar (*krw)(const Params &params, Scalar sw);
+        Scalar (*krn)(const Params &params, Scalar sw);
+    };
+
+    template<SalinityMode mode>
+    static Scalar pc_(const Params &params, Scalar sw)
+    { return EffLaw::template pc<mode>(params, swToSwe<mode>(params, sw)); }
+
+    template<SalinityMode mode>
+    static Scalar krw_(const Params &params, Scalar sw)
+    { return EffLaw::template krw<mode>(params, swToSwe<mode>(params, sw)); }
+
+    template<SalinityMode mode>
+    static Scalar krn_(const Params &params, Scalar sw)
+    { return EffLaw::template krn<mode>(params, swToSwe<mode>(params, sw)); }
+
+    // indexed by SalinityMode
+    static const Kernels kernels_[2];
+
     static Scalar 
     interpolate(Scalar salinityFraction, Scalar min, Scalar max){       
         if (salinityFraction < 1e-6) {
@@ -366,6 +396,12 @@ public:
         //return 1. - params.swr() - params.snr();
     }
 };
+
+template <class EffLawT, class AbsParamsT>
+const typename EffToAbsLaw<EffLawT, AbsParamsT>::Kernels EffToAbsLaw<EffLawT, AbsParamsT>::kernels_[2] = {
+    { pc_<SalinityMode::interpolated>, krw_<SalinityMode::interpolated>, krn_<SalinityMode::interpolated> },
+    { pc_<SalinityMode::constant>, krw_<SalinityMode::constant>, krn_<SalinityMode::constant> }
+};
 }
 
 #endif
@@ -43,6 +43,10 @@ namespace Dumux
  *
  * For general info: EffToAbsLaw
  *
+ * pc, dpc_dswe, krw and krn take the SalinityMode as template argument:
+ * with SalinityMode::constant only the high salinity curve is evaluated.
+ * The default keeps the run time test of LS() == HS().
+ *
  *\see BrooksCoreyParams
  */
 template <class ScalarT, class ParamsT = ModifiedBrooksCoreyFIParams<ScalarT> >
@@ -70,6 +74,7 @@ public:
      * \note Instead of undefined behaviour if pc is not in the valid range, we return a valid number,
      *       by clamping the input.
      */
+    template<SalinityMode mode = SalinityMode::interpolated>
     static Scalar pc(const Params& params, Scalar swe)
     {
         using std::pow;
@@ -80,7 +85,7 @@ public:
 
         const Scalar pc_HS = params.pe_HS()*pow(swe, -1.0/params.lambda_HS());
 
-        if (params.LS() == params.HS())
+        if (mode == SalinityMode::constant || params.LS() == params.HS())
         {
             return pc_HS;
         }
@@ -164,6 +169,7 @@ public:
      * \note Instead of undefined behaviour if pc is not in the valid range, we return a valid number,
      *       by clamping the input.
      */
+    template<SalinityMode mode = SalinityMode::interpolated>
     static Scalar dpc_dswe(const Params& params, Scalar swe)
     {
         using std::pow;
@@ -173,7 +179,7 @@ public:
         swe = min(max(swe, 0.0), 1.0); // the equation below is only defined for 0.0 <= sw <= 1.0
 
         const Scalar dpc_dswe_HS = - params.pe_HS()/params.lambda_HS() * pow(swe, -1/params.lambda_HS() - 1);
-        if (params.LS() == params.HS())
+        if (mode == SalinityMode::constant || params.LS() == params.HS())
         {
             return dpc_dswe_HS;
         }
@@ -233,6 +239,7 @@ public:
      * \note Instead of undefined behaviour if pc is not in the valid range, we return a valid number,
      *       by clamping the input.
      */
+    template<SalinityMode mode = SalinityMode::interpolated>
     static Scalar krw(const Params& params, Scalar swe)
     {
         using std::pow;
@@ -243,7 +250,7 @@ public:
 
         //return pow(swe, 2.0/params.lambda() + 3);
         const Scalar krw_HS = params.k0rw_HS() * pow(swe, params.nw_HS());
-        if (params.LS() == params.HS())
+        if (mode == SalinityMode::constant || params.LS() == params.HS())
         {
             TRACE("params.LS() == params.HS()\n");
             return krw_HS;
@@ -310,6 +317,7 @@ public:
      * \note Instead of undefined behaviour if pc is not in the valid range, we return a valid number,
      *       by clamping the input.
      */
+    template<SalinityMode mode = SalinityMode::interpolated>
     static Scalar krn(const Params& params, Scalar swe)
     {
         using std::pow;
@@ -320,7 +328,7 @@ public:
 
         const Scalar krn_HS = params.k0rn_HS() * pow(1 - swe, params.nn_HS());
 
-        if (params.LS() == params.HS())
+        if (mode == SalinityMode::constant || params.LS() == params.HS())
         {
             return krn_HS;
         }
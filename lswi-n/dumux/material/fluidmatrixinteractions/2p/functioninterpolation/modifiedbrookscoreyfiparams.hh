@@ -31,6 +31,17 @@
 namespace Dumux
 {
 
+/*!
+ * \brief How the material law treats the salinity.
+ *
+ * interpolated: the curves are blended between the high and the low
+ *               salinity parameters by the salinity S().
+ * constant:     only the high salinity parameters are used. This is
+ *               what the interpolated kernels reduce to for LS() == HS()
+ *               and for the BCM, without testing it on every call.
+ */
+enum class SalinityMode { interpolated = 0, constant = 1 };
+
 /*!
  * \brief Specification of the material parameters
  *       for the Brooks Corey constitutive relations.
@@ -48,14 +59,16 @@ public:
     ModifiedBrooksCoreyFIParams()
     {
         Valgrind::SetUndefined(*this);
+        salinityMode_ = SalinityMode::interpolated;
     }
 
     ModifiedBrooksCoreyFIParams(Scalar pe, Scalar lambda)
-        : pe_HS_(pe), pe_LS_(pe), lambda_HS_(lambda), lambda_LS_(lambda)
+        : pe_HS_(pe), pe_LS_(pe), lambda_HS_(lambda), lambda_LS_(lambda),
+          salinityMode_(SalinityMode::interpolated)
     {
     }
 
-    void dump(void){
+    void dump(void) const {
         DBG("MatrixPe:       Hi = %le  Low = %le \n", pe_HS_,pe_LS_); 
         DBG("MatrixLambda:   Hi = %le  Low = %le \n", lambda_HS_,lambda_LS_); 
         DBG("MatrixKrwMax:   Hi = %le  Low = %le \n", k0rw_HS_,k0rw_LS_); 
@@ -63,6 +76,8 @@ public:
         DBG("Matrixnw:       Hi = %le  Low = %le \n", nw_HS_,nw_LS_); 
         DBG("Matrixnn:       Hi = %le  Low = %le \n", nn_HS_,nn_LS_); 
         DBG("SalinityLimits: Hi = %le  Low = %le \n", HS_,LS_); 
+        DBG("SalinityMode:   %s\n",
+            (salinityMode_ == SalinityMode::constant)? "constant" : "interpolated");
 
     }
 
@@ -212,6 +227,16 @@ public:
         LS_ = v; 
     }
 
+    /*!
+     * \brief Kernels used by EffToAbsLaw, set once per episode
+     *        by the spatial parameters.
+     */
+    SalinityMode salinityMode() const
+    { return salinityMode_; }
+
+    void setSalinityMode(SalinityMode mode)
+    { salinityMode_ = mode; }
+
 private:
 
     mutable Scalar S_;
@@ -235,6 +260,7 @@ private:
     mutable Scalar nn_LS_;
     mutable Scalar LS_;
 
+    SalinityMode salinityMode_;
 };
 } // namespace Dumux
 
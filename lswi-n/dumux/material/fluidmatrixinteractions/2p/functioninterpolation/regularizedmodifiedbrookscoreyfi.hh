@@ -81,6 +81,7 @@ public:
      *
      * \copydetails BrooksCorey::pc()
      */
+    template<SalinityMode mode = SalinityMode::interpolated>
     static Scalar pc(const Params& params, Scalar swe)
     {
         const Scalar sThres = params.thresholdSw();
@@ -92,19 +93,19 @@ public:
         // saturation moving to the right direction if it
         // temporarily is in an 'illegal' range.
         if (swe <= sThres) {
-            Scalar m = ModifiedBrooksCoreyFI::dpc_dswe(params, sThres);
-            Scalar pcsweLow = ModifiedBrooksCoreyFI::pc(params, sThres);
+            Scalar m = ModifiedBrooksCoreyFI::template dpc_dswe<mode>(params, sThres);
+            Scalar pcsweLow = ModifiedBrooksCoreyFI::template pc<mode>(params, sThres);
             return pcsweLow + m*(swe - sThres);
         }
         else if (swe > 1.0) {
-            Scalar m = ModifiedBrooksCoreyFI::dpc_dswe(params, 1.0);
-            Scalar pcsweHigh = ModifiedBrooksCoreyFI::pc(params, 1.0);
+            Scalar m = ModifiedBrooksCoreyFI::template dpc_dswe<mode>(params, 1.0);
+            Scalar pcsweHigh = ModifiedBrooksCoreyFI::template pc<mode>(params, 1.0);
             return pcsweHigh + m*(swe - 1.0);
         }
 
         // if the effective saturation is in an 'reasonable'
         // range, we use the real Brooks-Corey law...
-        return ModifiedBrooksCoreyFI::pc(params, swe);
+        return ModifiedBrooksCoreyFI::template pc<mode>(params, swe);
     }
 
     /*!
@@ -255,13 +256,14 @@ public:
      *  For not-regularized part:
         \copydetails BrooksCorey::krw()
      */
+    template<SalinityMode mode = SalinityMode::interpolated>
     static Scalar krw(const Params &params, Scalar swe)
     {
         if (swe <= 0.0)
             return 0.0;
         else if (swe >= 1.0)
         {
-          if (params.LS() == params.HS())
+          if (mode == SalinityMode::constant || params.LS() == params.HS())
           {
               return params.k0rw_HS();
           }
@@ -269,7 +271,7 @@ public:
           return nS*params.k0rw_HS()+ (1-nS)*params.k0rw_LS();
           // return params.k0rw_HS();
         }
-        return ModifiedBrooksCoreyFI::krw(params, swe);
+        return ModifiedBrooksCoreyFI::template krw<mode>(params, swe);
     }
 
     /*!
@@ -286,13 +288,14 @@ public:
      * \copydetails BrooksCorey::krn()
      *
      */
+    template<SalinityMode mode = SalinityMode::interpolated>
     static Scalar krn(const Params &params, Scalar swe)
     {
         if (swe >= 1.0)
             return 0.0;
         else if (swe <= 0.0)
         {
-          if (params.LS() == params.HS())
+          if (mode == SalinityMode::constant || params.LS() == params.HS())
           {
               return params.k0rn_HS();
           }
@@ -301,7 +304,7 @@ public:
           // return params.k0rn_HS();
         }
 
-        return ModifiedBrooksCoreyFI::krn(params, swe);
+        return ModifiedBrooksCoreyFI::template krn<mode>(params, swe);
     }
 };
 }
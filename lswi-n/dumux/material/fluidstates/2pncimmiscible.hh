@@ -0,0 +1,246 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+/*!
+ * \file
+ * \ingroup FluidStates
+ * \brief Compact fluid state of the isothermal two-phase immiscible
+ *        n-component model.
+ */
+#ifndef DUMUX_2PNC_IMMISCIBLE_FLUID_STATE_HH
+#define DUMUX_2PNC_IMMISCIBLE_FLUID_STATE_HH
+
+#include <array>
+#include <cassert>
+
+namespace Dumux {
+
+/*!
+ * \ingroup FluidStates
+ * \brief Fluid state of the two-phase immiscible n-component model which
+ *        only stores what the model uses.
+ *
+ * The generic CompositionalFluidState keeps mole fractions, fugacity
+ * coefficients, enthalpies and temperatures of every component and phase.
+ * With the TwoPNCImmiscible fluid system the single component phase always
+ * consists of the last component only (the oil), the multicomponent phase
+ * (the brine) never contains it, and the model is isothermal. Here only the
+ * brine mole fractions of components 0 ... lastCompIdx-1 are stored, the
+ * oil composition is implied. Pressures, saturations, densities, molar
+ * densities and viscosities are kept per phase, the temperature once.
+ *
+ * The interface is the one of CompositionalFluidState, restricted to the
+ * states the model can be in: setting a mole fraction which contradicts
+ * the immiscibility asserts, enthalpies are always zero.
+ */
+template <class ScalarType, class FluidSystem>
+class TwoPNCImmiscibleFluidState
+{
+public:
+    static constexpr int numPhases = FluidSystem::numPhases;
+    static constexpr int numComponents = FluidSystem::numComponents;
+
+    //! export the scalar type
+    using Scalar = ScalarType;
+
+    static_assert(numPhases == 2, "The immiscible fluid state requires two phases");
+
+    TwoPNCImmiscibleFluidState()
+    {
+        // the brine is pure water until a composition is set
+        moleFraction_.fill(0.0);
+        moleFraction_[FluidSystem::comp0Idx] = 1.0;
+        updateAverageMolarMass_();
+    }
+
+    /*****************************************************
+     * Generic access to fluid properties
+     *****************************************************/
+    //! The index of the wetting phase
+    int wettingPhase() const { return wPhaseIdx_; }
+
+    //! The saturation of a fluid phase \f$\mathrm{[-]}\f$
+    Scalar saturation(int phaseIdx) const
+    { return saturation_[phaseIdx]; }
+
+    //! The mole fraction of a component in a phase \f$\mathrm{[-]}\f$
+    Scalar moleFraction(int phaseIdx, int compIdx) const
+    {
+        if (phaseIdx == FluidSystem::multicomponentPhaseIdx)
+            return (compIdx == FluidSystem::lastCompIdx)? 0.0 : moleFraction_[compIdx];
+        return (compIdx == FluidSystem::lastCompIdx)? 1.0 : 0.0;
+    }
+
+    //! The mass fraction of a component in a phase \f$\mathrm{[-]}\f$
+    Scalar massFraction(int phaseIdx, int compIdx) const
+    {
+        if (phaseIdx == FluidSystem::multicomponentPhaseIdx)
+            return sumMoleFractions_*moleFraction(phaseIdx, compIdx)
+                   *FluidSystem::molarMass(compIdx)/averageMolarMass_;
+        return moleFraction(phaseIdx, compIdx);
+    }
+
+    //! The average molar mass of a phase \f$\mathrm{[kg/mol]}\f$
+    Scalar averageMolarMass(int phaseIdx) const
+    {
+        if (phaseIdx == FluidSystem::multicomponentPhaseIdx)
+            return averageMolarMass_;
+        return FluidSystem::molarMass(FluidSystem::lastCompIdx);
+    }
+
+    //! The molar concentration of a component in a phase \f$\mathrm{[mol/m^3]}\f$
+    Scalar molarity(int phaseIdx, int compIdx) const
+    { return molarDensity(phaseIdx)*moleFraction(phaseIdx, compIdx); }
+
+    //! The pressure of a fluid phase \f$\mathrm{[Pa]}\f$
+    Scalar pressure(int phaseIdx) const
+    { return pressure_[phaseIdx]; }
+
+    //! The specific enthalpy of a fluid phase, zero for the isothermal model
+    Scalar enthalpy(int phaseIdx) const
+    { return 0.0; }
+
+    //! The specific internal energy of a fluid phase, zero for the isothermal model
+    Scalar internalEnergy(int phaseIdx) const
+    { return 0.0; }
+
+    //! The mass density of a fluid phase \f$\mathrm{[kg/m^3]}\f$
+    Scalar density(int phaseIdx) const
+    { return density_[phaseIdx]; }
+
+    //! The molar density of a fluid phase \f$\mathrm{[mol/m^3]}\f$
+    Scalar molarDensity(int phaseIdx) const
+    { return molarDensity_[phaseIdx]; }
+
+    //! The temperature of a fluid phase \f$\mathrm{[K]}\f$
+    Scalar temperature(int phaseIdx) const
+    { return temperature_; }
+
+    //! The temperature, the same for all phases \f$\mathrm{[K]}\f$
+    Scalar temperature() const
+    { return temperature_; }
+
+    //! The dynamic viscosity of a fluid phase \f$\mathrm{[Pa s]}\f$
+    Scalar viscosity(int phaseIdx) const
+    { return viscosity_[phaseIdx]; }
+
+    /*****************************************************
+     * Setter methods
+     *****************************************************/
+    void setWettingPhase(int phaseIdx)
+    { wPhaseIdx_ = phaseIdx; }
+
+    void setTemperature(Scalar value)
+    { temperature_ = value; }
+
+    //! All phases share the temperature, the phase index is ignored.
+    void setTemperature(int phaseIdx, Scalar value)
+    { temperature_ = value; }
+
+    void setPressure(int phaseIdx, Scalar value)
+    { pressure_[phaseIdx] = value; }
+
+    void setSaturation(int phaseIdx, Scalar value)
+    { saturation_[phaseIdx] = value; }
+
+    /*!
+     * \brief Set the mole fraction of a component in a phase.
+     *
+     * Only the brine composition is stored. The oil may only be set to
+     * pure oil and the brine may not contain oil.
+     */
+    void setMoleFraction(int phaseIdx, int compIdx, Scalar value)
+    {
+        if (phaseIdx == FluidSystem::multicomponentPhaseIdx)
+        {
+            if (compIdx == FluidSystem::lastCompIdx)
+            {
+                assert(value == 0.0);
+                return;
+            }
+            moleFraction_[compIdx] = value;
+            updateAverageMolarMass_();
+            return;
+        }
+        assert(value == ((compIdx == FluidSystem::lastCompIdx)? 1.0 : 0.0));
+    }
+
+    void setDensity(int phaseIdx, Scalar value)
+    { density_[phaseIdx] = value; }
+
+    void setMolarDensity(int phaseIdx, Scalar value)
+    { molarDensity_[phaseIdx] = value; }
+
+    void setViscosity(int phaseIdx, Scalar value)
+    { viscosity_[phaseIdx] = value; }
+
+    //! The isothermal model has no enthalpies, the value is discarded.
+    void setEnthalpy(int phaseIdx, Scalar value)
+    { }
+
+    /*!
+     * \brief Retrieve all parameters from an arbitrary fluid state.
+     */
+    template <class FluidState>
+    void assign(const FluidState& fs)
+    {
+        for (int phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+        {
+            pressure_[phaseIdx] = fs.pressure(phaseIdx);
+            saturation_[phaseIdx] = fs.saturation(phaseIdx);
+            density_[phaseIdx] = fs.density(phaseIdx);
+            molarDensity_[phaseIdx] = fs.molarDensity(phaseIdx);
+            viscosity_[phaseIdx] = fs.viscosity(phaseIdx);
+        }
+        for (int compIdx = 0; compIdx < numBrineComponents; ++compIdx)
+            moleFraction_[compIdx] = fs.moleFraction(FluidSystem::multicomponentPhaseIdx, compIdx);
+        updateAverageMolarMass_();
+        temperature_ = fs.temperature(0);
+        wPhaseIdx_ = fs.wettingPhase();
+    }
+
+private:
+    static constexpr int numBrineComponents = FluidSystem::lastCompIdx;
+
+    // as CompositionalFluidState, from all mole fractions of the brine
+    void updateAverageMolarMass_()
+    {
+        sumMoleFractions_ = 0.0;
+        averageMolarMass_ = 0.0;
+        for (int compIdx = 0; compIdx < numBrineComponents; ++compIdx)
+        {
+            sumMoleFractions_ += moleFraction_[compIdx];
+            averageMolarMass_ += moleFraction_[compIdx]*FluidSystem::molarMass(compIdx);
+        }
+    }
+
+    std::array<Scalar, numBrineComponents> moleFraction_;
+    Scalar averageMolarMass_;
+    Scalar sumMoleFractions_;
+    std::array<Scalar, numPhases> pressure_ = {};
+    std::array<Scalar, numPhases> saturation_ = {};
+    std::array<Scalar, numPhases> density_ = {};
+    std::array<Scalar, numPhases> molarDensity_ = {};
+    std::array<Scalar, numPhases> viscosity_ = {};
+    Scalar temperature_ = 0.0;
+    int wPhaseIdx_ = FluidSystem::phase0Idx;
+};
+
+} // end namespace Dumux
+
+#endif
@@ -25,6 +25,7 @@
 #define DUMUX_2PNC_IMMISCIBLE_FLUID_SYSTEM_HH
 
 #include <dumux/material/fluidsystems/base.hh>
+#include <dumux/material/fluidsystems/nullparametercache.hh>
 
 #include <dumux/common/valgrind.hh>
 #include <dumux/common/exceptions.hh>
@@ -72,6 +73,33 @@ public:
     static constexpr int comp0Idx = 0;
     static constexpr int lastCompIdx = MultiComponentPhase::numComponents;
 
+    /*!
+     * \brief Parameter cache with the density and viscosity of the
+     *        multi component phase of the current episode.
+     *
+     * Values <= 0 (the default) use the properties of MultiComponentPhase.
+     * The volume variables set them from the spatial parameters.
+     */
+    class ParameterCache : public NullParameterCache
+    {
+    public:
+        void setMultiComponentPhase(Scalar density, Scalar viscosity)
+        {
+            density_ = density;
+            viscosity_ = viscosity;
+        }
+
+        Scalar density() const
+        { return density_; }
+
+        Scalar viscosity() const
+        { return viscosity_; }
+
+    private:
+        Scalar density_ = -1;
+        Scalar viscosity_ = -1;
+    };
+
     /****************************************
      * Fluid phase related static parameters
      ****************************************/
@@ -219,6 +247,18 @@ public:
         }
     }
 
+    /*!
+     * \brief The phase density [kg/m^3], the one of the parameter cache
+     *        for the multi component phase if it is set.
+     */
+    template <class FluidState>
+    static Scalar density(const FluidState& fluidState, const ParameterCache& paramCache, int phaseIdx)
+    {
+        if (phaseIdx == multicomponentPhaseIdx && paramCache.density() > 0)
+            return paramCache.density();
+        return density(fluidState, phaseIdx);
+    }
+
     /*!
      * \brief Return the viscosity of a phase.
      */
@@ -234,6 +274,18 @@ public:
         }
     }
 
+    /*!
+     * \brief The phase viscosity, the one of the parameter cache for the
+     *        multi component phase if it is set.
+     */
+    template <class FluidState>
+    static Scalar viscosity(const FluidState& fluidState, const ParameterCache& paramCache, int phaseIdx)
+    {
+        if (phaseIdx == multicomponentPhaseIdx && paramCache.viscosity() > 0)
+            return paramCache.viscosity();
+        return viscosity(fluidState, phaseIdx);
+    }
+
 
 
     /*!
@@ -39,38 +39,28 @@
 #include <dumux/common/valgrind.hh>
 #include <dumux/common/exceptions.hh>
 
-#ifndef BRINE_N_COMPONENTS
-#warning "assuming single particle in brine (BRINE_N_COMPONENTS = 2)"
-// components = water + particle count
-# define BRINE_N_COMPONENTS 2
-#endif
-
 namespace Dumux
 {
 
 namespace FluidSystems
 {
 
-// Global static variable to have a different constant density
-// for different episodes.
-// A value greater than zero indicates a constant density for the
-// episode.
-static double episodeDensity_=-1.0;
-static double episodeViscosity_=-1.0;
 static particle_t *FSparticles;
 
 
 
 /*!
  * \ingroup Fluidsystems
- * \brief A compositional single phase fluid system consisting of two components,
- *        which are H2O and Na+.
+ * \brief A compositional single phase fluid system consisting of H2O and
+ *        numParticles particles (ions) given in the input file.
  */
-template <class Scalar, class H2O = Dumux::Components::SimpleH2O<Scalar>>
+template <class Scalar, int numParticles, class H2O = Dumux::Components::SimpleH2O<Scalar>>
 class Brine : 
-    public Base< Scalar, Brine<Scalar, H2O>> // to pass on static functions of Base...
+    public Base< Scalar, Brine<Scalar, numParticles, H2O>> // to pass on static functions of Base...
 {
-    using ThisType = Brine<Scalar, H2O>;
+    static_assert(numParticles > 0, "The brine requires at least one particle");
+
+    using ThisType = Brine<Scalar, numParticles, H2O>;
     using StaticBase = Base<Scalar, ThisType>; // for static stuff with implementation
 
     // convenience using declarations
@@ -90,7 +80,7 @@ public:
     // and room temperature 20C:
 
     // components = water + particle count
-    static const int numComponents = BRINE_N_COMPONENTS; // H2O, NaCation
+    static const int numComponents = numParticles + 1; // H2O, NaCation
 
     static constexpr int H2OIdx = 0; // 0
 
@@ -148,8 +138,8 @@ public:
      */
     static std::string componentName(int compIdx)
     {
-        if (compIdx > BRINE_N_COMPONENTS - 1 or compIdx < 0){
-            DUNE_THROW(Dune::InvalidStateException, "Component index out of range" << compIdx << " maximum = " << BRINE_N_COMPONENTS-1);
+        if (compIdx > numComponents - 1 or compIdx < 0){
+            DUNE_THROW(Dune::InvalidStateException, "Component index out of range" << compIdx << " maximum = " << numComponents-1);
         }
         switch (compIdx)
         {
@@ -167,8 +157,8 @@ public:
      */
     static Scalar molarMass(int compIdx)
     {
-        if (compIdx > BRINE_N_COMPONENTS - 1 or compIdx < 0){
-            DUNE_THROW(Dune::InvalidStateException, "Component index out of range" << compIdx << " maximum = " << BRINE_N_COMPONENTS-1);
+        if (compIdx > numComponents - 1 or compIdx < 0){
+            DUNE_THROW(Dune::InvalidStateException, "Component index out of range" << compIdx << " maximum = " << numComponents-1);
         }
         switch (compIdx) {
         case H2OIdx: // zero
@@ -186,37 +176,34 @@ public:
      *
      */
 
-    static void init(Scalar initialDensity, Scalar initialViscosity, particle_t *particle_p)
+    static void init(particle_t *particle_p)
     {
-        episodeDensity_ = initialDensity;
-        episodeViscosity_ = initialViscosity;
         FSparticles = particle_p;
     }
 
     /*!
      * \brief Given all mole fractions in a phase, return the phase
      *        density. \f$\mathrm{[kg/m^3]}\f$.
-     *        Note: This fluidsystem will return  a specific constant
-     *        density if an episode density is not specified.
+     *        Note: This fluidsystem returns a constant density, the
+     *        density of an episode is passed by the parameter cache of
+     *        the two phase fluid system (TwoPNCImmiscible).
      */
     template <class FluidState>
     static Scalar density(const FluidState& fluidState, int phaseIdx = H2OIdx)
     {
-        if (episodeDensity_ > 0) return episodeDensity_;
         return 1130.0;
     }
 
     /*!
      * \brief Given all mole fractions in a phase, return the phase
-     *        viscosity. \f$\mathrm{[kg/m^3]}\f$.
-     *        Note: This fluidsystem will return  a specific constant
-     *        viscosity if an episode viscosity is not specified.
+     *        viscosity. \f$\mathrm{[Pa s]}\f$.
+     *        Note: This fluidsystem returns a constant viscosity, the
+     *        viscosity of an episode is passed as the density.
      */
     using StaticBase::viscosity;
     template <class FluidState>
     static Scalar viscosity(const FluidState& fluidState, int phaseIdx = H2OIdx)
     {
-        if (episodeViscosity_ > 0) return episodeViscosity_;
         return 3.0e-04;
     }
 
@@ -0,0 +1,52 @@
+/**************************************************************************
+ *  Copyright 2018 Instituto Mexicano del Petroleo
+ *
+ *     All rights reserved for internal usage
+ *     (If distributed to third parties,
+ *      please note DuMux opensource restrictions)
+ *
+ *  File(s):
+ *              chemical/chemicalmodel.hh
+ *              chemical/ions.hh
+ *
+ *  Description:
+ *
+ *     State of the chemical model of one cell, passed to the functions of
+ *     Ions (formerly defined by components/ionBrine.hh of the
+ *     2pnc-release3.0-chemical tree). The arrays are indexed by the
+ *     internal identifiers of Ions (Ions::_Na ... Ions::_vCO3MgRCOO), the
+ *     kinetic reactions by letter (A: 0, B: 1, C: 2).
+ *
+ *     molalities: concentrations [mol/kg water]
+ *     gamma:      activity coefficients
+ *     rateC:      reaction rates; [mol/kg water/s] inside Ions, converted
+ *                 to [mol/m3 brine/s] (times the brine density of the
+ *                 context) on return of Ions::ionicStrength()
+ *     R, Q:       rate [mol/m3/s] and saturation ratio of the kinetic
+ *                 reactions
+ *     psi:        surface potentials oil/water and solid/water [V]
+ *     iS:         ionic strength [mol/kg water]
+ *     density:    brine density for the volumetric ionic strength of
+ *                 the surface potentials
+ *
+ ***************************************************************************/
+#ifndef LSWF_CHEMICAL_MODEL_HH
+#define LSWF_CHEMICAL_MODEL_HH
+
+// Size of the component arrays (at least Ions::allComponents).
+#define CHEMICAL_MODEL_COMPONENTS 36
+// Size of the kinetic reaction arrays (at least Ions::maxKineticReactions).
+#define CHEMICAL_MODEL_REACTIONS 3
+
+typedef struct chemicalModel_t {
+    double molalities[CHEMICAL_MODEL_COMPONENTS];
+    double gamma[CHEMICAL_MODEL_COMPONENTS];
+    double rateC[CHEMICAL_MODEL_COMPONENTS];
+    double R[CHEMICAL_MODEL_REACTIONS];
+    double Q[CHEMICAL_MODEL_REACTIONS];
+    double psi[2];
+    double iS;
+    double density;
+} chemicalModel_t;
+
+#endif
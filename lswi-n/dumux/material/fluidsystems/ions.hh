@@ -21,7 +21,7 @@
  *              components/mgso4.hh
  *              components/oh-.hh
  *              components/co3--.hh
- *              components/ionBrine.hh
+ *              chemical/chemicalmodel.hh
  *
  *  Description:
  *
@@ -39,6 +39,13 @@
  *     BRINE_OIL_CHEMISTRY
  *     BRINE_SOLID_CHEMISTRY
  *     BRINE_OIL_SOLID_CHEMISTRY (required BRINE_OIL_CHEMISTRY and BRINE_SOLID_CHEMISTRY
+ *
+ *     The first three cases fix the transported ions (the components of the
+ *     model). The kinetic reactions (A, B, C) are described by the constexpr
+ *     reaction networks (networks_), which may be selected at run time
+ *     (setNetwork()) among those whose species are transported. The
+ *     preprocessor case only chooses the default network.
+ *
  *     USE_ACTIVITY_COEFICIENTS:
  *       If defined, activities are calculated from ionic strength functions. Otherwise,
  *       all equilibrium reactions are considered ideal, i.e., activity coeficients are
@@ -46,6 +53,20 @@
  *     ALL_IONS_FOR_IS:
  *       If defined, positive and negative ion concentrations are used for ionic strength
  *       calculation. Otherwise, only positive ions are used for calculation of ionic strength
+ *     FIXED_POINT_SPECIATION:
+ *       If defined, ionic strength and electroneutrality are solved by the former
+ *       fixed point iteration (solveIonicStrength()). Otherwise a Newton-Raphson
+ *       solver with analytic Jacobian is used (solveSpeciation()). Both are capped
+ *       (maxSpeciationIterations) and report convergence in speciationStatus_t.
+ *     SOLVE_ODES:
+ *       If defined, the kinetic (mineral) reactions A, B, C change the transported
+ *       concentrations over the time step in solveODEs(). A negative time step
+ *       skips the ODE's.
+ *     EXPLICIT_ODES:
+ *       If defined, solveODEs() uses the former explicit update with one step.
+ *       Otherwise the kinetic subsystem is integrated with the linearly implicit
+ *       Rosenbrock method ROS2, with error control and substeps (odeTolerance,
+ *       maxOdeSubsteps), reported in speciationStatus_t.
  *
  * Reactions involved (equilibrium and reaction rate constants indexed by letter):
  * A: CaCO3(s) + H+ <--> Ca++ + HCO3-
@@ -87,50 +108,67 @@
 
 
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <utility>
 #include <dumux/material/components/base.hh>
  
 //#include "2pnc-release3.0-chemical/material/components/myOil1.hh"
 
+#include <dumux/material/constants.hh>
+
+// State of the chemical model of a cell (chemicalModel_t)
+#include "chemicalmodel.hh"
 // Transported and non transported ions
-#include "2pnc-release3.0-chemical/material/components/ionBrine.hh"
 // Transported components: Na+, Ca++, H+, Mg++, HCO3-, SO4--, Cl-
-#include "2pnc-release3.0-chemical/material/components/na+.hh"
-#include "2pnc-release3.0-chemical/material/components/ca++.hh"
-#include "2pnc-release3.0-chemical/material/components/h+.hh"
-#include "2pnc-release3.0-chemical/material/components/mg++.hh"
-#include "2pnc-release3.0-chemical/material/components/hco3-.hh"
-#include "2pnc-release3.0-chemical/material/components/so4--.hh"
-#include "2pnc-release3.0-chemical/material/components/cl-.hh"
+// Non transported components: CaCl+, CaSO4-(suspended), MgCl+, NaSO4-,
+// MgSO4, OH-, CO3-- (constexpr properties, see componentTable_)
+#include <dumux/material/components/cations.hh>
+#include <dumux/material/components/anions.hh>
+#include <dumux/material/components/inert.hh>
 #include <dumux/material/components/simpleh2o.hh>
-// Non transported components: CaCl+, CaSO4-(suspended), MgCl+, NaSO4-
-#include "2pnc-release3.0-chemical/material/components/cacl+.hh"
-#include "2pnc-release3.0-chemical/material/components/caso4.hh"
-#include "2pnc-release3.0-chemical/material/components/mgcl+.hh"
-#include "2pnc-release3.0-chemical/material/components/naso4-.hh"
-#include "2pnc-release3.0-chemical/material/components/mgso4.hh"
-#include "2pnc-release3.0-chemical/material/components/oh-.hh"
-#include "2pnc-release3.0-chemical/material/components/co3--.hh"
-
-
-# undef TRACE
-# define TRACE(...)   { (void)0; }
-//# define TRACE(...)  fprintf(stderr, "TRACE> "); fprintf(stderr, __VA_ARGS__);
-# undef DBG
-# define DBG(...)  fprintf(stderr, "DBG> "); fprintf(stderr, __VA_ARGS__);
-
-
-static double brineDensity_;
-static double k1A_;
-static double k1B_;
-static double k1C_;
-static double ionicStrength_;
+
+
+// DBG, TRACE (off with -DNODEBUG as in the simulation driver)
+#include "dumux/common/debugmacros.hh"
+
+
 namespace Dumux
 {
+// Result of a speciation solve: convergence flag, Newton (or fixed
+// point) iterations of the ionic strength/electroneutrality system,
+// outer iterations of the reaction rate loop and the final relative
+// residual. With SOLVE_ODES, also the accepted and rejected substeps
+// of the kinetic integration, and the change of the kinetic species
+// (Ions::kineticSpecies_) by the integration over the step [mol/kg],
+// without the speciation before and after it.
+typedef struct speciationStatus_t {
+    bool converged;
+    int iterations;
+    int outerIterations;
+    double residual;
+    int odeSubsteps;
+    int odeRejected;
+    double kineticChange[5];
+} speciationStatus_t;
+
 template <class Scalar>
 class Ions
 {
 public:
+    // Iteration caps and relative tolerance for the speciation solvers.
+    static const int maxSpeciationIterations = 50;
+    static const int maxReactionRateIterations = 50;
+    static constexpr Scalar speciationTolerance = 1e-10;
+    // Substep cap and relative/absolute (molality) tolerances of the
+    // kinetic integration in solveODEs().
+    static const int maxOdeSubsteps = 1000;
+    static constexpr Scalar odeTolerance = 1e-3;
+    static constexpr Scalar odeAbsTolerance = 1e-12;
+
     typedef Constants<Scalar> Constant;
 
     typedef Components::SimpleH2O<Scalar> Water;
@@ -273,41 +311,172 @@ public:
     };
     // Export the defined total components.
     static const int allComponents = _allComponents;
+    // Equilibrium reactions 'A'..'W'
+    static const int numReactions = 'W'-'A'+1;
+
+    // Reaction networks: the kinetic reactions solved by solveR().
+    //
+    // A kinetic reaction dissolves (R > 0) or precipitates a mineral,
+    //     mineral <--> sum_i nu_i species_i,
+    // with R = -k1*(Q - 1) and Q = prod_i (gamma_i [species_i])^nu_i / K,
+    // where K and k1 are those of the reaction letter. The residual and
+    // Jacobian kernels are generated from the table for every network
+    // (kineticKernel_<network>()), the Context selects which one runs.
+    static const int maxKineticReactions = 3;
+    static const int maxReactionSpecies = 3;
+    typedef struct kineticReaction_t {
+        char id;                                // 'A'..'C'
+        int mineral;
+        int numSpecies;
+        int species[maxReactionSpecies];
+        int nu[maxReactionSpecies];             // stoichiometric coeficients
+    } kineticReaction_t;
+    typedef struct reactionNetwork_t {
+        const char *name;
+        int numReactions;
+        kineticReaction_t reaction[maxKineticReactions];
+    } reactionNetwork_t;
+
+    static const int numNetworks = 3;
+    static constexpr reactionNetwork_t networks_[numNetworks] = {
+        {"CaCO3", 1, {
+            {'A', _CaCO3s, 3, {_Ca, _HCO3, _H}, {1, 1, -1}}}},      // CaCO3(s) + H+ <--> Ca++ + HCO3-
+        {"CaCO3-CaSO4", 2, {
+            {'A', _CaCO3s, 3, {_Ca, _HCO3, _H}, {1, 1, -1}},
+            {'B', _CaSO4s, 2, {_Ca, _SO4}, {1, 1}}}},              // CaSO4(s) <--> Ca++ + SO4--
+        {"CaCO3-CaSO4-MgCO3", 3, {
+            {'A', _CaCO3s, 3, {_Ca, _HCO3, _H}, {1, 1, -1}},
+            {'B', _CaSO4s, 2, {_Ca, _SO4}, {1, 1}},
+            {'C', _MgCO3s, 3, {_Mg, _HCO3, _H}, {1, 1, -1}}}}      // MgCO3(s) + H+ <--> Mg++ + HCO3-
+    };
+#if defined(SIMPLE_CACO3)
+    static const int defaultNetwork = 0;
+#elif defined(CACO3_CASO4)
+    static const int defaultNetwork = 1;
+#else
+    static const int defaultNetwork = 2;
+#endif
+
+    // Kinetic species: concentrations changed by the reactions of any
+    // network (state of solveODEs()).
+    static const int numKineticSpecies = 5;
+    static constexpr int kineticSpecies_[numKineticSpecies] = {_Ca, _H, _HCO3, _SO4, _Mg};
+    static constexpr int kineticIndex_(int species){
+        for (int i=0; i<numKineticSpecies; i++) if (kineticSpecies_[i] == species) return i;
+        return -1;
+    }
+    static_assert(sizeof(speciationStatus_t::kineticChange) == numKineticSpecies*sizeof(double),
+                  "speciationStatus_t::kineticChange needs one entry per kinetic species");
+    static_assert(CHEMICAL_MODEL_COMPONENTS >= _allComponents && CHEMICAL_MODEL_REACTIONS >= maxKineticReactions,
+                  "chemicalModel_t (chemicalmodel.hh) is too small for the components of Ions");
+
+    // Context: all state of the chemical model besides the cell data
+    // in chemicalModel_t, passed alongside it to every solve. It holds
+    // the temperature dependent constants (evaluated once by
+    // makeContext(), since temperature is constant for the run) and
+    // the episode parameters set by the problem. Ions itself has no
+    // mutable static state: concurrent solves only need one Context
+    // per thread (or a shared one which is not modified meanwhile,
+    // see warned). Temperature independent component properties are
+    // in the constexpr componentTable_.
+    typedef struct Context {
+        Scalar temperature;
+        Scalar K[numReactions];         // equilibrium constants 'A'..'W'
+        Scalar A;                       // Debye-Hueckel A(T)
+        Scalar B;                       // Debye-Hueckel B(T)
+        Scalar brineDensity;            // kg/m3
+        Scalar k1[3];                   // rate constants 'A'..'C'
+        int network;                    // kinetic reactions, networks_ index
+        Scalar ionicStrength;
+        int warned;                     // negative input concentrations corrected
+    } Context;
+
+    // Component properties, indexed by the component enum. Components
+    // which are not listed (phases, solids, interface species) are
+    // not "known" and have ideal activity.
+    typedef struct componentProperties_t {
+        bool known;
+        bool ideal;             // ideal activity (gamma = 1)
+        bool isAcid;
+        int valence;
+        Scalar z2;              // valence^2
+        Scalar a;
+        Scalar b;
+        Scalar molarMass;
+        Scalar isWeight;        // weight in the ionic strength sum
+    } componentProperties_t;
+    typedef struct componentTable_t {
+        componentProperties_t p[allComponents];
+    } componentTable_t;
     
     // Class template global functions
     //
-    Ions(void){
-        // XXX: These are default values. They are reset in lswf-problem.hh
-       /* brineDensity_ = 1000.0;
-        k1A_ = 1.73743e-05;
-        k1B_ = 3.47486e-06;
-        k1C_ = 1.73743e-08;*/
+    // makeContext(): context at temperature [K] (default: the former
+    //                default temperature of K()). Episode parameters are
+    //                zero until set by the problem (setBrineDensity(),
+    //                setK1A(), ...), as the former file scope values.
+    static Context makeContext(Scalar temperature=110+273.15){
+        Context ctx;
+        ctx.temperature = temperature;
+        for (int r=0; r<numReactions; r++) ctx.K[r] = K('A'+r, temperature);
+        ctx.A = A(temperature);
+        ctx.B = B(temperature);
+        ctx.brineDensity = 0;
+        ctx.k1[0] = ctx.k1[1] = ctx.k1[2] = 0;
+        ctx.network = defaultNetwork;
+        ctx.ionicStrength = 0;
+        ctx.warned = 0;
+        return ctx;
+    }
+
+    static Scalar brineDensity(const Context *ctx){return ctx->brineDensity;}
+    static void setBrineDensity(Context *ctx, Scalar value){
+        if (value == ctx->brineDensity) return;
+        DBG("Ions::Changing brine density: %le-> %le\n", ctx->brineDensity, value);
+        ctx->brineDensity = value;
     }
-    static Scalar brineDensity(void){return brineDensity_;}
-    static void setBrineDensity(Scalar value){
-        if (value == brineDensity_) return;
-        DBG("Ions::Changing default brine density: %le-> %le\n", brineDensity_, value);
-        brineDensity_ = value;
+    static void setK1A(Context *ctx, Scalar value){
+        if (value == ctx->k1[0]) return;
+        DBG("Ions::Changing k1A: %le-> %le\n", ctx->k1[0], value);
+        ctx->k1[0] = value;
     }
-    static void setK1A(Scalar value){
-        if (value == k1A_) return;
-        DBG("Ions::Changing default k1A: %le-> %le\n", k1A_, value);
-        k1A_ = value;
+    static void setK1B(Context *ctx, Scalar value){
+        if (value == ctx->k1[1]) return;
+        DBG("Ions::Changing k1B: %le-> %le\n", ctx->k1[1], value);
+        ctx->k1[1] = value;
     }
-    static void setK1B(Scalar value){
-        if (value == k1B_) return;
-        DBG("Ions::Changing default k1B: %le-> %le\n", k1B_, value);
-        k1B_ = value;
+    static void setK1C(Context *ctx, Scalar value){
+        if (value == ctx->k1[2]) return;
+        DBG("Ions::Changing k1C: %le-> %le\n", ctx->k1[2], value);
+        ctx->k1[2] = value;
     }
-    static void setK1C(Scalar value){
-        if (value == k1C_) return;
-        DBG("Ions::Changing default k1C: %le-> %le\n", k1C_, value);
-        k1C_ = value;
+    static int network(const Context *ctx){return ctx->network;}
+    static const char *networkName(int network){return networks_[network].name;}
+    // setNetwork(): selects the kinetic reactions by network name. The
+    //               species of the network must be transported.
+    static void setNetwork(Context *ctx, const std::string &name){
+        for (int n=0; n<numNetworks; n++){
+            if (name != networks_[n].name) continue;
+            for (int r=0; r<networks_[n].numReactions; r++){
+                const kineticReaction_t &reaction = networks_[n].reaction[r];
+                for (int s=0; s<reaction.numSpecies; s++){
+                    if (reaction.species[s] >= numComponents){
+                        DUNE_THROW(Dune::InvalidStateException, "setNetwork(): network " << name
+                                   << " needs " << Ions::name(reaction.species[s]) << ", which is not transported");
+                    }
+                }
+            }
+            if (n == ctx->network) return;
+            DBG("Ions::Changing network: %s-> %s\n", networks_[ctx->network].name, networks_[n].name);
+            ctx->network = n;
+            return;
+        }
+        DUNE_THROW(Dune::InvalidStateException, "setNetwork(): unknown reaction network " << name);
     }
-    static void setIonicStrength(Scalar value){
-        if (value == ionicStrength_) return;
-        DBG("Ions::Changing default ionic strength: %le-> %le\n", ionicStrength_, value);
-        k1C_ = value;
+    static void setIonicStrength(Context *ctx, Scalar value){
+        if (value == ctx->ionicStrength) return;
+        DBG("Ions::Changing ionic strength: %le-> %le\n", ctx->ionicStrength, value);
+        ctx->ionicStrength = value;
     }
 
     //
@@ -336,67 +505,22 @@ public:
     // molarMass(): returns the molecular mass of the component in mol/kg/1000
     // (division by 1000 since DuMux uses m3 as volumen unit).
     static Scalar molarMass(int compIdx) {
-        switch (compIdx) {
-            case brineIdx: return Water::molarMass();
-            //case oilIdx:   return MyOil::molarMass();
-
-            case NaIdx:return NaCation::molarMass();
-            case CaIdx:return CaCation::molarMass();
-            case HIdx:return HCation::molarMass();
-            case MgIdx:return MgCation::molarMass();
-            case HCO3Idx: return HCO3Anion::molarMass();
-            case SO4Idx: return SO4Anion::molarMass();
-            case ClIdx: return ClAnion::molarMass();
-            case H2OIdx: return H20::molarMass();
-            case OHIdx: return OHAnion::molarMass();
-            case CaClIdx: return CaClCation::molarMass();
-            case MgClIdx: return MgClCation::molarMass();
-            case NaSO4Idx: return NaSO4Anion::molarMass();
-            case CaSO4Idx: return CaSO4suspended::molarMass();
-            case CO3Idx: return CO3Anion::molarMass();
-        }
-        DUNE_THROW(Dune::InvalidStateException, "ionMolarMass(): Invalid component index " << compIdx);
+        if (compIdx == brineIdx || compIdx == H2OIdx) return Water::molarMass();
+        return property_(compIdx, "molarMass()").molarMass;
     }
     // isAcid(): returns boolean value "true" if ion is acidic (proton donor).
     static bool isAcid(int compIdx) {
-        switch (compIdx) {
-            case NaIdx:return NaCation::isAcid();
-            case CaIdx:return CaCation::isAcid();
-            case HIdx:return HCation::isAcid();
-            case MgIdx:return MgCation::isAcid();
-            case HCO3Idx: return HCO3Anion::isAcid();
-            case SO4Idx: return SO4Anion::isAcid();
-            case ClIdx: return ClAnion::isAcid();
-            case H2OIdx: return false;
-            case OHIdx: return OHAnion::isAcid();
-            case CaClIdx: return CaClCation::isAcid();
-            case MgClIdx: return MgClCation::isAcid();
-            case NaSO4Idx: return NaSO4Anion::isAcid();
-            case CaSO4Idx: return CaSO4suspended::isAcid();
-            case CO3Idx: return CO3Anion::isAcid();
-        }
-        DUNE_THROW(Dune::InvalidStateException, "ionIsAcid(): Invalid component index " << compIdx);
+        return property_(compIdx, "isAcid()").isAcid;
     }
     // valence(); returns chemical valence of component.
     static Scalar valence(int compIdx) {
-        switch (compIdx){
-            case NaIdx:return NaCation::valence();
-            case CaIdx:return CaCation::valence();
-            case HIdx:return HCation::valence();
-            case MgIdx:return MgCation::valence();
-            case HCO3Idx: return HCO3Anion::valence();
-            case SO4Idx: return SO4Anion::valence();
-            case ClIdx: return ClAnion::valence();
-            case H2OIdx: return 0;
-            case OHIdx: return OHAnion::valence();
-            case CaClIdx: return CaClCation::valence();
-            case MgClIdx: return MgClCation::valence();
-            case NaSO4Idx: return NaSO4Anion::valence();
-            case CaSO4Idx: return CaSO4suspended::valence();
-            case CO3Idx: return CO3Anion::valence();
-            case MgSO4Idx: return MgSO4::valence();
-        }
-        DUNE_THROW(Dune::InvalidStateException, "ionValence(): Invalid component index " << compIdx);
+        return property_(compIdx, "valence()").valence;
+    }
+    // molalRate(): rate of component compIdx [mol/kg water/s] of a chemical
+    //              model returned by ionicStrength(), whose rateC is in
+    //              DuMux units [mol/m3 brine/s] (see chemicalmodel.hh).
+    static Scalar molalRate(const chemicalModel_t *cm, const Context *ctx, int compIdx) {
+        return cm->rateC[compIdx] / ctx->brineDensity;
     }
     //////////////////////////////////////////////////////////////////////////
     // ionicStrength(); global access function to solve chemical
@@ -410,25 +534,25 @@ public:
     // Same as above, but without solving ODE's when timeStepSize < 0
 
     // note: here ionic strength comes in with cm->iS
-   static Scalar ionicStrength(chemicalModel_t *cm){
+   static Scalar ionicStrength(chemicalModel_t *cm, Context *ctx){
         Scalar *Ct = cm->molalities;
         //cm->iS = getIonicStrength(cm); 
-        calculateGammas(cm); // Gammas with input iS. Will consider constant.
-	solveEquilibrium(cm);
+        calculateGammas(cm, ctx); // Gammas with input iS. Will consider constant.
+	solveEquilibrium(cm, ctx);
 	// Final reaction rates and Q values (gammas do not change)
-        solveR(cm);
+        solveR(cm, ctx);
 	// Assign reaction rates for output to solutionDependentSourceTerm().
         // Here we need to convert back to mol/m3/s (DuMux units)
         // Internally we work with molal velocity, mol/kg/s.
         for (int componentIdx=0; componentIdx < numComponents; componentIdx++){
             // For Dumux we must convert our reaction rates from molal mol/kg/s to mol/m3/s
-            cm->rateC[componentIdx] = cm->rateC[componentIdx] * brineDensity();
+            cm->rateC[componentIdx] = cm->rateC[componentIdx] * ctx->brineDensity;
         }
         //exit(1);
         return cm->iS;
    }
 #ifdef SIMPLIFIED
-   static Scalar ionicStrength(Scalar timeStepSize, chemicalModel_t *cm){
+   static Scalar ionicStrength(Scalar timeStepSize, chemicalModel_t *cm, Context *ctx){
         // Set up initial concentrations in Ct memory pointer
         Scalar *Ct = cm->molalities;
 	// We get first ionic strength with Cl from input value.
@@ -436,18 +560,18 @@ public:
 	// (subject to transport).
 	// requires Ca, H, HCO3, SO4, Na, Mg, Cl
         cm->iS = getIonicStrength(cm); 
-        calculateGammas(cm); // Gammas with input iS. Will consider constant.
+        calculateGammas(cm, ctx); // Gammas with input iS. Will consider constant.
 
 	// Now we get from equilibrium(iS): _OH, _NaSO4 which are required for 
 	// solving electroneutrality.
-	solveEquilibrium(cm);
+	solveEquilibrium(cm, ctx);
  
 	// Now we have all we need to solve ionic strength
 	//    this will iterate on ionic strength and on equilibrium 
 	//    concentrations and Cl concentration by electroneutrality.
         //
         // Does iS change with solve instead of get? (should not)
-        // Scalar solvedIS =  solveIonicStrength(cm);
+        // Scalar solvedIS =  solveIonicStrength(cm, ctx);
         // TRACE("get vs solved is: %le == %le (delta = %le)\n", cm->iS, solvedIS, fabs(cm->iS - solvedIS));
         // exit(1);
         // Result is exactly the same as with get instead of solve
@@ -457,25 +581,31 @@ public:
         
         /*
         // solveReactionRates() will alter [Cl] by electronegativity
-        cm->iS = solveReactionRates(-1.0, cm); // negative timestep skips ODE's
+        cm->iS = solveReactionRates(-1.0, cm, ctx); // negative timestep skips ODE's
         DBG("after second pass Ca--> gamma=%lf, [Ca]=%lf QA=%lf QB=%lf QC=%lf\n",
                 cm->gamma[_Ca], cm->molalities[_Ca], cm->Q[0], cm->Q[1], cm->Q[2]);
         */
 	// Final reaction rates and Q values (gammas do not change, but Q values do...)
-        solveR(cm);
+        solveR(cm, ctx);
         TRACE("after second pass Ca--> gamma=%lf, [Ca]=%lf QA=%lf QB=%lf QC=%lf\n",
                 cm->gamma[_Ca], cm->molalities[_Ca], cm->Q[0], cm->Q[1], cm->Q[2]);
 	// Assign reaction rates for output to solutionDependentSourceTerm().
         for (int componentIdx=0; componentIdx < numComponents; componentIdx++){
             // For Dumux we must convert our reaction rates from molal mol/kg/s to mol/m3/s
-            cm->rateC[componentIdx] = cm->rateC[componentIdx] * brineDensity();
+            cm->rateC[componentIdx] = cm->rateC[componentIdx] * ctx->brineDensity;
         }
         //exit(1);
         return cm->iS;
     }
 #else //  not SIMPLIFIED
-   // Should work as the call without timeStepSize, when solve ODE is not set
-    static Scalar ionicStrength(Scalar timeStepSize, chemicalModel_t *cm){
+   // Should work as the call without timeStepSize, when solve ODE is not set.
+   // If status is not null, the convergence of the speciation is returned
+   // there; otherwise a failure is only reported.
+    static Scalar ionicStrength(Scalar timeStepSize, chemicalModel_t *cm, Context *ctx,
+                                speciationStatus_t *status=nullptr){
+        speciationStatus_t localStatus;
+        if (!status) status = &localStatus;
+        *status = {true, 0, 0, 0.0, 0, 0};
         // Set up initial concentrations in Ct memory pointer
         Scalar *Ct = cm->molalities;
         // XXX: transport may be feeding negative concentrations...
@@ -485,7 +615,7 @@ public:
         //      instead... 
         //       
         // Check for invalid input concentrations and correct:
-        checkAllPositive(cm);
+        checkAllPositive(cm, ctx);
         //
         //
 	// We get first ionic strength with Cl from input value.
@@ -493,45 +623,60 @@ public:
 	// (subject to transport).
 	// requires Ca, H, HCO3, SO4, Na, Mg, Cl
         cm->iS = getIonicStrength(cm); 
-        calculateGammas(cm); // Gammas with initial iS.
+#ifndef FIXED_POINT_SPECIATION
+        // Newton-Raphson on ionic strength and electroneutrality, with
+        // gammas and equilibrium concentrations consistent with the result.
+        speciationStatus_t speciation = solveSpeciation(cm, ctx);
+        status->iterations += speciation.iterations;
+        status->residual = speciation.residual;
+        status->converged = speciation.converged;
+#else
+        calculateGammas(cm, ctx); // Gammas with initial iS.
 	// Now we get from equilibrium(iS): _OH, _NaSO4 which are required for 
 	// solving electroneutrality.
-	solveEquilibrium(cm);
+	solveEquilibrium(cm, ctx);
 	// With _OH, _NaSO4 we can now adjust Cl by electroneutrality:
 	// this requires Ct[_Ca], Ct[_Mg], Ct[_SO4], Ct[_CO3], Ct[_H],
 	//               Ct[_Na], Ct[_OH], Ct[_HCO3], Ct[_NaSO4].
 #ifdef SOLVE_CL
-        cm->molalities[_Cl] = solveCl(cm);  // by electroneutrality
+        cm->molalities[_Cl] = solveCl(cm, ctx);  // by electroneutrality
 #else
 #warning "[Cl] is by transport only: no electroneutrality consideration."
 #endif
 	// Now we have all we need to solve ionic strength:
 	//    this will iterate on ionic strength and on equilibrium 
 	//    concentrations and Cl concentration by electroneutrality.
-        cm->iS = solveIonicStrength(cm); 
+        cm->iS = solveIonicStrength(cm, ctx, status); 
         TRACE("is=%lf\n", cm->iS);
 	// Make sure we have all chemical variables updated to final iS.
-        calculateGammas(cm); // Calculate final gammas.
-        solveEquilibrium(cm); // final equilibrium.
+        calculateGammas(cm, ctx); // Calculate final gammas.
+        solveEquilibrium(cm, ctx); // final equilibrium.
 #ifdef SOLVE_CL
-        cm->molalities[_Cl] = solveCl(cm);  // by electroneutrality
+        cm->molalities[_Cl] = solveCl(cm, ctx);  // by electroneutrality
 #endif
+#endif // FIXED_POINT_SPECIATION
 	
 	// Solve for chemical kinetics at final chemical values.
         TRACE("first pass Ca--> gamma=%lf\n", cm->gamma[_Ca]);
-        cm->iS = solveReactionRates(-1.0, cm); // negative timestep skips ODE's
+        // With SOLVE_ODES the kinetics change the concentrations over
+        // timeStepSize (negative timestep skips ODE's).
+        cm->iS = solveReactionRates(timeStepSize, cm, ctx, status);
+        if (!status->converged && status == &localStatus) {
+            DBG("Ions::ionicStrength(): speciation did not converge (%d iterations, %d outer, residual %le)\n",
+                    status->iterations, status->outerIterations, status->residual);
+        }
         TRACE("after second pass Ca--> gamma=%lf, [Ca]=%lf QA=%lf QB=%lf QC=%lf\n",
                 cm->gamma[_Ca], cm->molalities[_Ca], cm->Q[0], cm->Q[1], cm->Q[2]);
 	// Final reaction rates and Q values.
-        solveR(cm);
+        solveR(cm, ctx);
         TRACE("after second pass Ca--> gamma=%lf, [Ca]=%lf QA=%lf QB=%lf QC=%lf\n",
                 cm->gamma[_Ca], cm->molalities[_Ca], cm->Q[0], cm->Q[1], cm->Q[2]);
 
 	// Assign reaction rates for output to solutionDependentSourceTerm().
         for (int componentIdx=0; componentIdx < numComponents; componentIdx++){
             // For Dumux we must convert our reaction rates from mol/kg/s to mol/m3/s
-            // This is done by multiplying by brineDensity() which comes in kg/m3
-            cm->rateC[componentIdx] = cm->rateC[componentIdx] * brineDensity();
+            // This is done by multiplying by the brine density which comes in kg/m3
+            cm->rateC[componentIdx] = cm->rateC[componentIdx] * ctx->brineDensity;
         }
         return cm->iS;
     }
@@ -548,116 +693,86 @@ private:
     //                     the instantaneous associated ionic strength.
     static Scalar getIonicStrength(chemicalModel_t *cm){
         double *Ct = cm->molalities;
-#ifdef SIMPLE_CACO3
-#  ifdef ALL_IONS_FOR_IS
-        int items[]={CaIdx, HIdx, HCO3Idx, ClIdx, -1};
-#  else
-        int items[]={CaIdx, HIdx, -1};
-#  endif
-#endif
-#ifdef CACO3_CASO4
-#  ifdef ALL_IONS_FOR_IS
-        int items[]={CaIdx, HIdx, HCO3Idx, SO4Idx, NaIdx, ClIdx, -1};
-#  else
-        int items[]={CaIdx, HIdx, NaIdx, -1};
-#  endif
-#endif
-#ifdef CACO3_CASO4_MGCO3
-#  ifdef ALL_IONS_FOR_IS
-        int items[]={CaIdx, HIdx, HCO3Idx, SO4Idx, NaIdx, MgIdx, ClIdx, -1};
-#  else
-        int items[]={CaIdx, HIdx, NaIdx, MgIdx, -1};
-#  endif
-#endif
-        // Check only pertinent components for NAN:
-        for (int i=0; items[i]>0; i++){
-            int compIdx=items[i];
-            if (isnan(Ct[compIdx])){
-                std::cerr << "partial checkNAN: nan at element "<< compIdx << "\n";
-                DUNE_THROW(Dune::InvalidStateException, "getIonicStrength(): NAN at component id: " << compIdx);
-            } 
-        }
         // check all components for NAN:
-         checkNAN(Ct);
+        checkNAN(Ct);
        
-        // I = (4*(Ca + M       g + SO4) + H + Na + HCO3 + Cl)/2
+        // I = (4*(Ca + Mg + SO4) + H + Na + HCO3 + Cl)/2
+        // Transported ions are contiguous (numPhases...numComponents-1);
+        // weights are zero for ions not considered (see isWeight_()).
+        const componentProperties_t *p = componentTable_.p;
         Scalar newiS = 0.0;
-        for (int i=0; items[i]>0; i++){
-            int compIdx=items[i];
-            int v = abs(valence(compIdx));
-            TRACE("valence(%s) = %d\n", name(compIdx).c_str(), v);
-            if (v >= 2) v*=2;
-            newiS += (v * Ct[compIdx]);
-            if (newiS < 0) {
-                DBG("newiS < 0\n");
-            }
-            TRACE("incremental %s newiS = %le\n", name(compIdx).c_str(), newiS);
+        for (int i=numPhases; i<numComponents; i++){
+            newiS += p[i].isWeight * Ct[i];
         }
         newiS /= 2.0;
         TRACE( "*** point ionicStrength(): %le\n", newiS);
         return newiS;
     }
-   // a(): returns the value of constant "a" for component.
+    // useIdealGamma(): ideal activity (gamma = 1) for the component.
     static bool useIdealGamma(int compIdx) {
-        switch (compIdx){
-            case NaIdx:
-            case CaIdx:
-            case HIdx:
-            case MgIdx:
-            case HCO3Idx:
-            case SO4Idx:
-            case ClIdx: 
-            case OHIdx: 
-            case CaClIdx:
-            case MgClIdx:
-            case NaSO4Idx:
-            case CaSO4Idx:
-            case CO3Idx: 
-            case MgSO4Idx:
-                return false;
-        }
-        return true;
+        if (compIdx < 0 || compIdx >= allComponents) return true;
+        return componentTable_.p[compIdx].ideal;
     }
     // a(): returns the value of constant "a" for component.
     static Scalar a(int compIdx) {
-        switch (compIdx){
-            case NaIdx:return NaCation::a();
-            case CaIdx:return CaCation::a();
-            case HIdx:return HCation::a();
-            case MgIdx:return MgCation::a();
-            case HCO3Idx: return HCO3Anion::a();
-            case SO4Idx: return SO4Anion::a();
-            case ClIdx: return ClAnion::a();
-            case OHIdx: return OHAnion::a();
-            case CaClIdx: return CaClCation::a();
-            case MgClIdx: return MgClCation::a();
-            case NaSO4Idx: return NaSO4Anion::a();
-            case CaSO4Idx: return CaSO4suspended::a();
-            case CO3Idx: return CO3Anion::a();
-            case MgSO4Idx: return MgSO4::a();
-        }
-        DUNE_THROW(Dune::InvalidStateException, "a(): Invalid component index " << compIdx);
+        return property_(compIdx, "a()").a;
     }
     // b(): returns the value of constant "b" for component.
     static Scalar b(int compIdx) {
+        return property_(compIdx, "b()").b;
+    }
+    // property_(): table entry of a known component.
+    static const componentProperties_t &property_(int compIdx, const char *what) {
+        if (compIdx < 0 || compIdx >= allComponents || !componentTable_.p[compIdx].known)
+            DUNE_THROW(Dune::InvalidStateException, what << ": Invalid component index " << compIdx);
+        return componentTable_.p[compIdx];
+    }
+    // properties_(): properties of component class C.
+    template <class C>
+    static constexpr componentProperties_t properties_(Scalar isWeight) {
+        return {true, false, C::isAcid(), C::valence(), Scalar(C::valence()*C::valence()),
+                C::a(), C::b(), C::molarMass(), isWeight};
+    }
+    // isWeight_(): weight of a transported ion in the ionic strength,
+    //              I = sum(z^2 m)/2. Without ALL_IONS_FOR_IS only cations
+    //              are considered.
+    static constexpr Scalar isWeight_(int valence) {
+#ifdef ALL_IONS_FOR_IS
+        return valence*valence;
+#else
+        return (valence > 0)? valence*valence : 0;
+#endif
+    }
+    // componentProperties_(): table entry for a component index.
+    static constexpr componentProperties_t componentProperties_(int compIdx) {
         switch (compIdx){
-            case NaIdx:return NaCation::b();
-            case CaIdx:return CaCation::b();
-            case HIdx:return HCation::b();
-            case MgIdx:return MgCation::b();
-            case HCO3Idx: return HCO3Anion::b();
-            case SO4Idx: return SO4Anion::b();
-            case ClIdx: return ClAnion::b();
-            case OHIdx: return OHAnion::b();
-            case CaClIdx: return CaClCation::b();
-            case MgClIdx: return MgClCation::b();
-            case NaSO4Idx: return NaSO4Anion::b();
-            case CaSO4Idx: return CaSO4suspended::b();
-            case MgSO4Idx: return MgSO4::b();
-            case CO3Idx: return CO3Anion::b();
+            // transported ions (contribute to the ionic strength)
+            case NaIdx: return properties_<NaCation>(isWeight_(NaCation::valence()));
+            case CaIdx: return properties_<CaCation>(isWeight_(CaCation::valence()));
+            case HIdx: return properties_<HCation>(isWeight_(HCation::valence()));
+            case MgIdx: return properties_<MgCation>(isWeight_(MgCation::valence()));
+            case HCO3Idx: return properties_<HCO3Anion>(isWeight_(HCO3Anion::valence()));
+            case SO4Idx: return properties_<SO4Anion>(isWeight_(SO4Anion::valence()));
+            case ClIdx: return properties_<ClAnion>(isWeight_(ClAnion::valence()));
+            // equilibrium species
+            case OHIdx: return properties_<OHAnion>(0);
+            case CaClIdx: return properties_<CaClCation>(0);
+            case MgClIdx: return properties_<MgClCation>(0);
+            case NaSO4Idx: return properties_<NaSO4Anion>(0);
+            case CaSO4Idx: return properties_<CaSO4suspended>(0);
+            case CO3Idx: return properties_<CO3Anion>(0);
+            case MgSO4Idx: return properties_<MgSO4>(0);
+            case H2OIdx: return {true, true, false, 0, 0, 0, 0, 0, 0};
         }
-        DUNE_THROW(Dune::InvalidStateException, "b(): Invalid component index " << compIdx);
+        return {false, true, false, 0, 0, 0, 0, 0, 0};
     }
+    static constexpr componentTable_t makeComponentTable_(void) {
+        componentTable_t table{};
+        for (int i=0; i<allComponents; i++) table.p[i] = componentProperties_(i);
+        return table;
+    }
+    static const componentTable_t componentTable_;
+
     // A(): returns the value of constant "A" for chemical system temperature.
     static Scalar A(Scalar temperature=130+273.15){
 
@@ -682,22 +797,22 @@ private:
     }
     // k1(): returns the value of k1, k2, k3 reaction rate constants, indexed
     //       by the reaction letter identifier (A-->1, B-->2, C-->3).
-    static Scalar k1(char reaction) {
+    static Scalar k1(const Context *ctx, char reaction) {
         // We use the k1 values in mol/lt/s since conversion to mol/kg/s is used internally
        switch (reaction){
-           case 'A': return k1A_; //1.2e-05;// This is in mol/m3/s (molar velocity)
-           case 'B': return k1B_; // 1.2e-08;
-           case 'C': return k1C_; // 2.4e-06;
+           case 'A': return ctx->k1[0]; //1.2e-05;// This is in mol/m3/s (molar velocity)
+           case 'B': return ctx->k1[1]; // 1.2e-08;
+           case 'C': return ctx->k1[2]; // 2.4e-06;
        }
        DUNE_THROW(Dune::InvalidStateException, "k1(): Invalid reaction index " << reaction);
     }
     // logK(): returns the log10 value of the reaction equilibrium constant, indexed
     //         by the reaction letter identifier.
     static Scalar logK(char reaction, Scalar temperature=110+273.15){
-        static Scalar low['W'-'A'+1]={1.85, -4.36, 2.3, -2.3, -13.99, -10.33, -7.87,
+        static const Scalar low['W'-'A'+1]={1.85, -4.36, 2.3, -2.3, -13.99, -10.33, -7.87,
                              -0.7, -0.15, -0.7, -2.37, -5.0, -1.2, -1.0, 11.8,
                              -2.10, 6.0, -5.1, -2.5, -2.5, -5.9, -5.9, -5.9};
-        static Scalar high['W'-'A'+1]={0.58, -5.34, -0.01, 2.61, -12.24, -10.27, -8.67,
+        static const Scalar high['W'-'A'+1]={0.58, -5.34, -0.01, 2.61, -12.24, -10.27, -8.67,
                               -0.54, -0.74, -0.77, -2.46, -5.0, -1.2, -1.3,
                               11.8, -3.25, 6.0, -5.1, -3.4, -3.4, -5.9, -5.9, -5.9};
         if (reaction > 'W' || reaction < 'A'){
@@ -712,11 +827,15 @@ private:
     }
     // K(): returns the value of the reaction equilibrium constant, indexed
     //      by the reaction letter identifier.
-    static Scalar K(char reaction, Scalar temperature=110+273.15){
+    static Scalar K(char reaction, Scalar temperature){
         return alog(logK(reaction, temperature));
     }
+    // K(): as above, at the context temperature (precomputed).
+    static Scalar K(const Context *ctx, char reaction){
+        return ctx->K[reaction-'A'];
+    }
     // gamma(): returns the activity coeficient for the component at a given
-    //          ionic strength value.
+    //          ionic strength value (reference version of calculateGammas()).
     static Scalar gamma(int componentIdx, Scalar iS, Scalar T=383.15){
         if (iS < 0) return 1; // ideal case.
         // Return ideal activity if component is not in coded consideration
@@ -732,9 +851,21 @@ private:
         return alog(logGamma);
     }
 
-    static void calculateGammas(chemicalModel_t *cm){
-        for (int componentIdx=0; componentIdx<allComponents; componentIdx++){
-            cm->gamma[componentIdx] = gamma(componentIdx, cm->iS, 373);
+    // calculateGammas(): activity coeficients of all components at cm->iS,
+    //                    same expression as gamma() with context constants.
+    static void calculateGammas(chemicalModel_t *cm, Context *ctx){
+        const Scalar iS = cm->iS;
+        if (iS < 0) { // ideal case.
+            for (int i=0; i<allComponents; i++) cm->gamma[i] = 1.0;
+            return;
+        }
+        const Scalar sqrtIS = sqrt(iS);
+        const componentProperties_t *p = componentTable_.p;
+        for (int i=0; i<allComponents; i++){
+            Scalar term1 = ctx->A * p[i].z2 * sqrtIS;
+            Scalar term2 = 1 + p[i].a * ctx->B * sqrtIS;
+            Scalar logGamma = p[i].b*iS - term1/term2;
+            cm->gamma[i] = p[i].ideal? 1.0 : alog(logGamma);
         }
     }
 
@@ -762,7 +893,7 @@ private:
     static void checkNAN(Scalar *Ct){
         for (int i=0; i<_allComponents; i++){
             TRACE("checkNAN ...element[%d] = %lf\n", i, Ct[i]);
-            if (isnan(Ct[i])){
+            if (std::isnan(Ct[i])){
                 mess(Ct, i, "NAN at element");
                 DUNE_THROW(Dune::InvalidStateException, "checkNAN: nan at element "<< i << "\n");
             } 
@@ -770,7 +901,7 @@ private:
     }
     // solvePotentialOW(): returns the electrical potential at the
     //                     oil/brine interface.
-    static Scalar solvePotentialOW(chemicalModel_t *cm, Scalar T=373){
+    static Scalar solvePotentialOW(chemicalModel_t *cm, Context *ctx, Scalar T=373){
         // For psiOW we prevously need to have obtained:
         //    Ct[_Ca] ... OK (initialConcentrations)
         //    Ct[_Mg] ... OK  (initialConcentrations), 
@@ -780,19 +911,19 @@ private:
         Scalar Iv = iS * cm->density;
         
         Scalar C = (Constant::R*T) / (2 * Constant::F);
-        Scalar C2 = (GAMMA(_Ca) * Ct[_Ca]/K('M')) + (GAMMA(_Mg) * Ct[_Mg]/K('N'));
+        Scalar C2 = (GAMMA(_Ca) * Ct[_Ca]/K(ctx, 'M')) + (GAMMA(_Mg) * Ct[_Mg]/K(ctx, 'N'));
         Scalar S1 = epsilonW_ * epsilonO_ * Iv * Constant::R * T;
         //Scalar S2 = 2 * pow(g,2) * pow(Constant::F,2); // simplified two expressions sqrt(pow(x,2))
         Scalar C3 = sqrt(S1/2) / Ct[_RCOO] / Constant::F;
         Scalar psiOW = C * (C2 - 1)/(C2 + C3);
-        if (isnan(psiOW)){
+        if (std::isnan(psiOW)){
             DBG("nan at psiOW\n");
         }
         return (psiOW);
     }
     // solvePotentialSW(): returns the electrical potential at the
     //                     solid/brine interface.
-    static Scalar solvePotentialSW(chemicalModel_t *cm, Scalar T=373){
+    static Scalar solvePotentialSW(chemicalModel_t *cm, Context *ctx, Scalar T=373){
         // For psiSW we need:
         //    Ct[_vCaOH2] and Ct[_vCO3] (constants)
         //    Ct[_Ca] ... OK (initialConcentrations)
@@ -805,41 +936,41 @@ private:
         
         Scalar C = (Constant::R*T) / (2 * Constant::F);
         Scalar T1 = Ct[_vCaOH2] - Ct[_vCO3];
-        Scalar T2a = ( (GAMMA(_Ca) * Ct[_Ca] / K('S')) +
-                (GAMMA(_Mg) * Ct[_Mg] / K('T')) )  * Ct[_vCO3];
-        Scalar T2b = ( (GAMMA(_SO4) * Ct[_SO4] / K('P')) +
-                (GAMMA(_CO3) * Ct[_CO3] / K('Q')) ) * Ct[_vCaOH2];
+        Scalar T2a = ( (GAMMA(_Ca) * Ct[_Ca] / K(ctx, 'S')) +
+                (GAMMA(_Mg) * Ct[_Mg] / K(ctx, 'T')) )  * Ct[_vCO3];
+        Scalar T2b = ( (GAMMA(_SO4) * Ct[_SO4] / K(ctx, 'P')) +
+                (GAMMA(_CO3) * Ct[_CO3] / K(ctx, 'Q')) ) * Ct[_vCaOH2];
         Scalar T2 = T2a - T2b;
         Scalar S1 = epsilonW_ * epsilonO_ * Iv * Constant::R * T;
         Scalar T3 = T2 + (sqrt(S1/2) / Constant::F);
         return C * (T1 + T2) / T3;
     }
     // solveCl(): solve the Cl- concentration from electroneutrality computation.
-    static Scalar solveCl(chemicalModel_t *cm){
+    static Scalar solveCl(chemicalModel_t *cm, Context *ctx){
         Scalar iS = cm->iS;
         double *Ct = cm->molalities;
 #ifdef SIMPLE_CACO3
         Scalar term1a =  2*(Ct[_Ca] - Ct[_CO3]);
         Scalar term1b =  Ct[_H] - Ct[_OH] - Ct[_HCO3];
-        Scalar CaClterm = K('H')*Ct[_Ca]*GAMMA(_Ca)*GAMMA(_Cl)/GAMMA(_CaCl);
+        Scalar CaClterm = K(ctx, 'H')*Ct[_Ca]*GAMMA(_Ca)*GAMMA(_Cl)/GAMMA(_CaCl);
         Scalar MgClterm = 0;
 #endif
 #ifdef CACO3_CASO4
         Scalar term1a =  2*(Ct[_Ca] -  Ct[_SO4] - Ct[_CO3]);
         Scalar term1b =  Ct[_H] + Ct[_Na] - Ct[_OH] - Ct[_HCO3];
-        Scalar CaClterm = K('H')*Ct[_Ca]*GAMMA(_Ca)*GAMMA(_Cl)/GAMMA(_CaCl);
+        Scalar CaClterm = K(ctx, 'H')*Ct[_Ca]*GAMMA(_Ca)*GAMMA(_Cl)/GAMMA(_CaCl);
         Scalar MgClterm = 0;
 #endif
 #ifdef CACO3_CASO4_MGCO3
         Scalar term1a =  2*(Ct[_Ca] + Ct[_Mg] -  Ct[_SO4] - Ct[_CO3]);
         Scalar term1b =  Ct[_H] + Ct[_Na] - Ct[_OH] - Ct[_HCO3] - Ct[_NaSO4];
 
-        Scalar CaClterm = K('H')*Ct[_Ca]*GAMMA(_Ca)*GAMMA(_Cl)/GAMMA(_CaCl);
-        Scalar MgClterm = K('I')*Ct[_Mg]*GAMMA(_Mg)*GAMMA(_Cl)/GAMMA(_MgCl);
+        Scalar CaClterm = K(ctx, 'H')*Ct[_Ca]*GAMMA(_Ca)*GAMMA(_Cl)/GAMMA(_CaCl);
+        Scalar MgClterm = K(ctx, 'I')*Ct[_Mg]*GAMMA(_Mg)*GAMMA(_Cl)/GAMMA(_MgCl);
 #endif
         TRACE("Ions::solveCl: %lf/1-%lf-%lf = %lf\n", term1, CaClterm, MgClterm,
                 term1 / (1 - CaClterm - MgClterm));
-        if (isnan((term1a+term1b) / (1 - CaClterm - MgClterm))) {
+        if (std::isnan((term1a+term1b) / (1 - CaClterm - MgClterm))) {
             DBG( "Ions::solveCl: (%lf+%lf)/1-%lf-%lf = %lf\n", term1a, term1b,
                     CaClterm, MgClterm, (term1a+term1b) / (1 - CaClterm - MgClterm));
             exit(1);
@@ -857,10 +988,65 @@ private:
         if (fabs((Ct[_Cl] - newCl)/Ct[_Cl]) > 0.01)  TRACE("Electroneutrality: Cl --> newCl: %le --> %le\n", Ct[_Cl], newCl);
         return newCl;
     }
+    // dlnGamma(): derivative of ln(gamma) with respect to the ionic strength
+    //             (zero for ideal components or without activity coeficients).
+    static Scalar dlnGamma(const Context *ctx, int componentIdx, Scalar iS){
+#ifdef USE_ACTIVITY_COEFICIENTS
+        const componentProperties_t &p = componentTable_.p[componentIdx];
+        if (iS <= 0) return 0;
+        if (p.ideal) return 0;
+        Scalar sqrtIS = sqrt(iS);
+        Scalar term2 = 1 + p.a * ctx->B * sqrtIS;
+        Scalar dlogGamma = p.b - ctx->A * p.z2 / (2 * sqrtIS * term2 * term2);
+        return log(10.0) * dlogGamma;
+#else
+        return 0;
+#endif
+    }
+    // solveCl(): as above, but also returns the derivative of the Cl-
+    //            concentration with respect to the ionic strength (transported
+    //            concentrations fixed, equilibrium species from solveEquilibrium()).
+    static Scalar solveCl(chemicalModel_t *cm, Context *ctx, Scalar *dCl_dIS){
+        Scalar iS = cm->iS;
+        double *Ct = cm->molalities;
+        // d[X]/dI of the equilibrium species which enter electroneutrality
+        Scalar dOH = -Ct[_OH] * (dlnGamma(ctx, _OH, iS) + dlnGamma(ctx, _H, iS));
+        Scalar dCO3 = -Ct[_CO3] * (dlnGamma(ctx, _Ca, iS) + dlnGamma(ctx, _CO3, iS));
+        Scalar CaClterm = K(ctx, 'H')*Ct[_Ca]*GAMMA(_Ca)*GAMMA(_Cl)/GAMMA(_CaCl);
+        Scalar dCaClterm = CaClterm * (dlnGamma(ctx, _Ca, iS) + dlnGamma(ctx, _Cl, iS) - dlnGamma(ctx, _CaCl, iS));
+#ifdef SIMPLE_CACO3
+        Scalar term1 =  2*(Ct[_Ca] - Ct[_CO3]) + Ct[_H] - Ct[_OH] - Ct[_HCO3];
+        Scalar dterm1 = -2*dCO3 - dOH;
+        Scalar MgClterm = 0, dMgClterm = 0;
+#endif
+#ifdef CACO3_CASO4
+        Scalar term1 =  2*(Ct[_Ca] -  Ct[_SO4] - Ct[_CO3]) + Ct[_H] + Ct[_Na] - Ct[_OH] - Ct[_HCO3];
+        Scalar dterm1 = -2*dCO3 - dOH;
+        Scalar MgClterm = 0, dMgClterm = 0;
+#endif
+#ifdef CACO3_CASO4_MGCO3
+        Scalar dNaSO4 = Ct[_NaSO4] * (dlnGamma(ctx, _Na, iS) + dlnGamma(ctx, _SO4, iS) - dlnGamma(ctx, _NaSO4, iS));
+        Scalar term1 =  2*(Ct[_Ca] + Ct[_Mg] -  Ct[_SO4] - Ct[_CO3])
+                      + Ct[_H] + Ct[_Na] - Ct[_OH] - Ct[_HCO3] - Ct[_NaSO4];
+        Scalar dterm1 = -2*dCO3 - dOH - dNaSO4;
+        Scalar MgClterm = K(ctx, 'I')*Ct[_Mg]*GAMMA(_Mg)*GAMMA(_Cl)/GAMMA(_MgCl);
+        Scalar dMgClterm = MgClterm * (dlnGamma(ctx, _Mg, iS) + dlnGamma(ctx, _Cl, iS) - dlnGamma(ctx, _MgCl, iS));
+#endif
+        Scalar term2 = 1 - CaClterm - MgClterm;
+        Scalar dterm2 = -dCaClterm - dMgClterm;
+        Scalar newCl = term1 / term2;
+        if (term2 == 0 || !(newCl >= 0)) {
+            // same fallback as solveCl(): no negative Cl concentration
+            *dCl_dIS = 0;
+            return 0;
+        }
+        *dCl_dIS = (dterm1 * term2 - term1 * dterm2) / (term2 * term2);
+        return newCl;
+    }
     // solveEquilibrium(): fast reaction concentrations are solved by equilibrium.
     //                     Electrical potential taken into account for oil/brine,
     //                     solid/brine and oil/solid/brine interfaces.
-    static void solveEquilibrium(chemicalModel_t *cm, Scalar T=373){
+    static void solveEquilibrium(chemicalModel_t *cm, Context *ctx, Scalar T=373){
         double *Ct = cm->molalities;
         Scalar iS = cm->iS;
         // These concentrations are now activity modified.
@@ -868,44 +1054,44 @@ private:
         // Equilibrium relationships
         // Solve equilibrium (CO3 only by equilibrium):
 
-        Ct[_OH] = K('E') / GAMMA(_OH) / GAMMA(_H) / Ct[_H];                          // 4.2
-        Ct[_CO3] = K('A') * K('F') / GAMMA(_Ca) / Ct[_Ca] / GAMMA(_CO3); // 4.1
+        Ct[_OH] = K(ctx, 'E') / GAMMA(_OH) / GAMMA(_H) / Ct[_H];                          // 4.2
+        Ct[_CO3] = K(ctx, 'A') * K(ctx, 'F') / GAMMA(_Ca) / Ct[_Ca] / GAMMA(_CO3); // 4.1
 #if defined(CACO3_CASO4) || defined(CACO3_CASO4_MGCO3)
-        Ct[_CaSO4] = GAMMA(_Ca)*GAMMA(_SO4)*Ct[_Ca]*Ct[_SO4]/GAMMA(_CaSO4)/K('D');   // 4.4
-        Ct[_NaSO4] = GAMMA(_Na)*GAMMA(_SO4)*Ct[_Na]*Ct[_SO4]/GAMMA(_NaSO4)/K('J');   // 4.3
+        Ct[_CaSO4] = GAMMA(_Ca)*GAMMA(_SO4)*Ct[_Ca]*Ct[_SO4]/GAMMA(_CaSO4)/K(ctx, 'D');   // 4.4
+        Ct[_NaSO4] = GAMMA(_Na)*GAMMA(_SO4)*Ct[_Na]*Ct[_SO4]/GAMMA(_NaSO4)/K(ctx, 'J');   // 4.3
 #endif
 #if defined(CACO3_CASO4_MGCO3)
-        Ct[_MgSO4] = GAMMA(_Mg)*GAMMA(_SO4)*Ct[_Mg]*Ct[_SO4]/GAMMA(_MgSO4)/K('K');
+        Ct[_MgSO4] = GAMMA(_Mg)*GAMMA(_SO4)*Ct[_Mg]*Ct[_SO4]/GAMMA(_MgSO4)/K(ctx, 'K');
 #endif
 #ifdef BRINE_OIL_CHEMISTRY
         // brine/oil interface:
-        Scalar psiOW = solvePotentialOW(cm); // Now calculate oil/brine psi values
+        Scalar psiOW = solvePotentialOW(cm, ctx); // Now calculate oil/brine psi values
         cm->psi[0] = psiOW;
         // Activity coeficients not available for _R compounds (we assume ideal)
         // Ct[_RCOO] is assumed constant and was set from input file at setInitialConcentrations()
         //   (otherise we would have 3 equations and 4 unknowns)
-        Ct[_RCOOH] = exp(-psiOW*Constant::F/Constant::R/T)*GAMMA(_H)*Ct[_H]*Ct[_RCOO]/K('L'); 
-        if (isnan(Ct[_RCOOH])){
+        Ct[_RCOOH] = exp(-psiOW*Constant::F/Constant::R/T)*GAMMA(_H)*Ct[_H]*Ct[_RCOO]/K(ctx, 'L'); 
+        if (std::isnan(Ct[_RCOOH])){
                 DBG("nan at RCOOH\n");
         }
         // 5.1
-        Ct[_RCOOCa] = exp(-2*psiOW*Constant::F/Constant::R/T) * GAMMA(_Ca)*Ct[_Ca]*Ct[_RCOO]/K('M');  // 5.2
-        Ct[_RCOOMg] = exp(-2*psiOW*Constant::F/Constant::R/T) * GAMMA(_Mg)*Ct[_Mg]*Ct[_RCOO]/K('N');  // 5.3
+        Ct[_RCOOCa] = exp(-2*psiOW*Constant::F/Constant::R/T) * GAMMA(_Ca)*Ct[_Ca]*Ct[_RCOO]/K(ctx, 'M');  // 5.2
+        Ct[_RCOOMg] = exp(-2*psiOW*Constant::F/Constant::R/T) * GAMMA(_Mg)*Ct[_Mg]*Ct[_RCOO]/K(ctx, 'N');  // 5.3
         TRACE("Ct[_RCOOH] = %le, Ct[_RCOOCa] = %le, Ct[_RCOOMg] = %le\n",
                 Ct[_RCOOH], Ct[_RCOOCa], Ct[_RCOOMg]);
 #endif
 #ifdef BRINE_SOLID_CHEMISTRY
         // brine/solid interface:
         // Activity coeficients not available for ">" compounds (we assume ideal)
-        Scalar psiSW = solvePotentialSW(cm); // Now calculate solid/brine psi values
+        Scalar psiSW = solvePotentialSW(cm, ctx); // Now calculate solid/brine psi values
         cm->psi[1] = psiSW;
         // brine/solid
-        Ct[_vCaOH] = exp(psiSW*Constant::F/Constant::R/T) * Ct[_vCaOH2] / K('O') / GAMMA(_H) /Ct[_H]; // 5.3
-        Ct[_vCaSO4] = exp(-2*psiSW*Constant::F/Constant::R/T) * GAMMA(_SO4)*Ct[_SO4]*Ct[_vCaOH2] / K('P'); // 5.4
-        Ct[_vCaCO3] = exp(-2*psiSW*Constant::F/Constant::R/T) * GAMMA(_CO3)*Ct[_CO3]*Ct[_vCaOH2] / K('Q'); // 5.5
-        Ct[_vCO3H] = exp(-psiSW*Constant::F/Constant::R/T) * GAMMA(_H)*Ct[_H]*Ct[_vCO3] / K('R');     // 5.6
-        Ct[_vCO3Ca] = exp(-2*psiSW*Constant::F/Constant::R/T) * GAMMA(_Ca)*Ct[_Ca]*Ct[_vCO3] / K('S'); // 5.7
-        Ct[_vCO3Mg] = exp(-2*psiSW*Constant::F/Constant::R/T) * GAMMA(_Mg)*Ct[_Mg]*Ct[_vCO3] / K('T'); // 5.8
+        Ct[_vCaOH] = exp(psiSW*Constant::F/Constant::R/T) * Ct[_vCaOH2] / K(ctx, 'O') / GAMMA(_H) /Ct[_H]; // 5.3
+        Ct[_vCaSO4] = exp(-2*psiSW*Constant::F/Constant::R/T) * GAMMA(_SO4)*Ct[_SO4]*Ct[_vCaOH2] / K(ctx, 'P'); // 5.4
+        Ct[_vCaCO3] = exp(-2*psiSW*Constant::F/Constant::R/T) * GAMMA(_CO3)*Ct[_CO3]*Ct[_vCaOH2] / K(ctx, 'Q'); // 5.5
+        Ct[_vCO3H] = exp(-psiSW*Constant::F/Constant::R/T) * GAMMA(_H)*Ct[_H]*Ct[_vCO3] / K(ctx, 'R');     // 5.6
+        Ct[_vCO3Ca] = exp(-2*psiSW*Constant::F/Constant::R/T) * GAMMA(_Ca)*Ct[_Ca]*Ct[_vCO3] / K(ctx, 'S'); // 5.7
+        Ct[_vCO3Mg] = exp(-2*psiSW*Constant::F/Constant::R/T) * GAMMA(_Mg)*Ct[_Mg]*Ct[_vCO3] / K(ctx, 'T'); // 5.8
 #endif
 #ifdef BRINE_OIL_SOLID_CHEMISTRY
 #if !defined(BRINE_OIL_CHEMISTRY) || !defined(BRINE_SOLID_CHEMISTRY)
@@ -913,66 +1099,66 @@ private:
 #endif
         // brine/solid/oil
         Ct[_vCaOH2RCOO] =
-            exp(( psiSW - psiOW)*Constant::F/Constant::R/T)*Ct[_RCOO]*Ct[_vCaOH2] / K('U');
+            exp(( psiSW - psiOW)*Constant::F/Constant::R/T)*Ct[_RCOO]*Ct[_vCaOH2] / K(ctx, 'U');
         Ct[_vCO3CaRCOO] =
-            exp((-psiSW - psiOW)*Constant::F/Constant::R/T)*Ct[_RCOO]*Ct[_vCO3]*GAMMA(_Ca)*Ct[_Ca] / K('V');
+            exp((-psiSW - psiOW)*Constant::F/Constant::R/T)*Ct[_RCOO]*Ct[_vCO3]*GAMMA(_Ca)*Ct[_Ca] / K(ctx, 'V');
         Ct[_vCO3MgRCOO] =
-            exp((-psiSW - psiOW)*Constant::F/Constant::R/T)*Ct[_RCOO]*Ct[_vCO3]*GAMMA(_Mg)*Ct[_Mg] / K('W');
+            exp((-psiSW - psiOW)*Constant::F/Constant::R/T)*Ct[_RCOO]*Ct[_vCO3]*GAMMA(_Mg)*Ct[_Mg] / K(ctx, 'W');
 #endif
         return;
     }
     
-    static void checkReactionRateConsistency(chemicalModel_t *cm){
+    static void checkReactionRateConsistency(chemicalModel_t *cm, Context *ctx){
         double *Ct = cm->molalities;
         Scalar iS = cm->iS;
         // Check for direction of precipitation reactions (by equilibrium)
         // CaCO3s
         bool debugStop = false;
-        if (Ct[_Ca]*GAMMA(_Ca)*Ct[_HCO3]*GAMMA(_HCO3) / K('A') / Ct[_H] / GAMMA(_H)> 1){
+        if (Ct[_Ca]*GAMMA(_Ca)*Ct[_HCO3]*GAMMA(_HCO3) / K(ctx, 'A') / Ct[_H] / GAMMA(_H)> 1){
             TRACE("CaCO3 will precipitate: Ct[_Ca]*Ct[_HCO3]/ Ct[_H] = %le > K_A = %le\n",
-                    Ct[_Ca]*GAMMA(_Ca)*Ct[_HCO3]*GAMMA(_HCO3)/ Ct[_H]/GAMMA(_H), K('A'));
+                    Ct[_Ca]*GAMMA(_Ca)*Ct[_HCO3]*GAMMA(_HCO3)/ Ct[_H]/GAMMA(_H), K(ctx, 'A'));
             if (cm->rateC[CaCO3sIdx] < 0){
                 DBG("inconsistent cm->rateC[CaCO3sIdx]: should be positive\n");
                 debugStop = true;
             }
         } else {
             TRACE("CaCO3 will dissolve: Ct[_Ca]*Ct[_HCO3]/ Ct[_H] = %le < K_A = %le\n",
-                    Ct[_Ca]*GAMMA(_Ca)*Ct[_HCO3]*GAMMA(_HCO3)/ Ct[_H]/GAMMA(_H), K('A'));
+                    Ct[_Ca]*GAMMA(_Ca)*Ct[_HCO3]*GAMMA(_HCO3)/ Ct[_H]/GAMMA(_H), K(ctx, 'A'));
             if (cm->rateC[CaCO3sIdx] > 0){
                 DBG("inconsistent cm->rateC[CaCO3sIdx]: should be negative\n");
                 debugStop = true;
            }
         }
         // CaSO4s
-        if (Ct[_Ca]*GAMMA(_Ca)*Ct[_SO4]*GAMMA(_SO4)  / K('B')> 1){
+        if (Ct[_Ca]*GAMMA(_Ca)*Ct[_SO4]*GAMMA(_SO4)  / K(ctx, 'B')> 1){
             if (cm->rateC[CaSO4sIdx] < 0){
                 TRACE("inconsistent cm->rateC[CaSO4sIdx]: should be positive\n");
                 TRACE("CaSO4 will precipitate: Ct[_Ca]*Ct[_SO4] = %le < K_B = %le, cm->rateC[CaSO4sIdx]=%le\n"  ,
-                    Ct[_Ca]*GAMMA(_Ca)*Ct[_SO4]*GAMMA(_SO4), K('B'), cm->rateC[CaSO4sIdx]);
+                    Ct[_Ca]*GAMMA(_Ca)*Ct[_SO4]*GAMMA(_SO4), K(ctx, 'B'), cm->rateC[CaSO4sIdx]);
                 DBG("inconsistent cm->rateC[CaSO4sIdx]: should be positive\n");
                 debugStop = true;
             }
         } else {
             TRACE("CaSO4 will dissolve: Ct[_Ca]*Ct[_HCO3]/ Ct[_H] = %le < K_B = %le\n",
-                    Ct[_Ca]*GAMMA(_Ca)*Ct[_SO4]*GAMMA(_SO4), K('B'));
+                    Ct[_Ca]*GAMMA(_Ca)*Ct[_SO4]*GAMMA(_SO4), K(ctx, 'B'));
             if (cm->rateC[CaSO4sIdx] > 0){
                 TRACE("CaSO4 will precipitate: Ct[_Ca]*Ct[_SO4] = %le < K_B = %le, cm->rateC[CaSO4sIdx]=%le\n",
-                    Ct[_Ca]*GAMMA(_Ca)*Ct[_SO4]*GAMMA(_SO4), K('B'), cm->rateC[CaSO4sIdx]);
+                    Ct[_Ca]*GAMMA(_Ca)*Ct[_SO4]*GAMMA(_SO4), K(ctx, 'B'), cm->rateC[CaSO4sIdx]);
                 DBG("inconsistent cm->rateC[CaSO4sIdx]: should be negative\n");
                 debugStop = true;
             }
         }
         // MgCO3s
-        if (Ct[_Mg]*GAMMA(_Mg)*Ct[_HCO3]*GAMMA(_HCO3) / K('C') / Ct[_H] / GAMMA(_H)> 1){
+        if (Ct[_Mg]*GAMMA(_Mg)*Ct[_HCO3]*GAMMA(_HCO3) / K(ctx, 'C') / Ct[_H] / GAMMA(_H)> 1){
             TRACE("MgCO3s will precipitate: Ct[_Mg]*Ct[_HCO3]/ Ct[_H] = %le > K_C = %le\n",
-                    Ct[_Mg]*GAMMA(_Mg)*Ct[_HCO3]*GAMMA(_HCO3)/ Ct[_H]/GAMMA(_H), K('C'));
+                    Ct[_Mg]*GAMMA(_Mg)*Ct[_HCO3]*GAMMA(_HCO3)/ Ct[_H]/GAMMA(_H), K(ctx, 'C'));
             if (cm->rateC[MgCO3sIdx] < 0){
                 DBG("inconsistent cm->rateC[MgCO3sIdx]: should be positive\n");
                 debugStop = true;
             }
         } else {
             TRACE("CaCO3 will dissolve: Ct[_Ca]*Ct[_HCO3]/ Ct[_H] = %le < K_A = %le\n",
-                    Ct[_Ca]*GAMMA(_Ca)*Ct[_HCO3]*GAMMA(_HCO3)/ Ct[_H]/GAMMA(_H), K('A'));
+                    Ct[_Ca]*GAMMA(_Ca)*Ct[_HCO3]*GAMMA(_HCO3)/ Ct[_H]/GAMMA(_H), K(ctx, 'A'));
             if (cm->rateC[MgCO3sIdx] > 0){
                 DBG("inconsistent cm->rateC[MgCO3sIdx]: should be negative\n");
                 debugStop = true;
@@ -984,41 +1170,22 @@ private:
     }
 
     // solveDependentRates(): Solve reaction rates which depend on slow precipitation
-    static void solveDependentRates(chemicalModel_t *cm){
+    static void solveDependentRates(chemicalModel_t *cm, Context *ctx){
         double *R = cm->rateC;
-        double *Ct = cm->molalities;
         // Reaccion rates for precipitates consider that precipitate is
         // leaving the liquid phase. Thus, precipitation would imply a negative
         // rate. Thus the ions that are consumed to form the precipitate would
-        // also have a negative rate. This explains the reason for the sign in
-        // concentrations of Ca++, Mg++ and SO4--
-        //
-        // Dependent rates:
-        // H+ produced with precipitate CaCO3 and produced with precipitate MgCO3.
-        // HCO3- + Ca++ ---> H+ + CaCO3s
-        // HCO3- + Mg++ ---> H+ + MgCO3s
-        R[HIdx] = R[CaCO3sIdx] + R[MgCO3sIdx];         
-        // HCO3- consumed produced with precipitate CaCO3 and consumed with precipitate MgCO3.
+        // also have a negative rate: with the mineral on the left side of
+        // the reaction, species rate = -nu * mineral rate, e.g.
         // HCO3- + Ca++ ---> H+ + CaCO3s
-        // HCO3- + Mg++ ---> H+ + MgCO3s
-        R[HCO3Idx] = -R[CaCO3sIdx] - R[MgCO3sIdx]; 
-        // Ca++ consumed with precipitate CaCO3 and consumed with precipitate CaSO4
-        // HCO3- + Ca++ ---> H+ + CaCO3s
-        // Ca++ + SO4-- ---> CaSO4s
-        R[CaIdx] = -R[CaCO3sIdx] - R[CaSO4sIdx]; // (stoichiometric rate)
-        //R[CaIdx] = R[CaCO3sIdx] + R[CaSO4sIdx]; // eq. 55 (confusion rate)
-        // SO4-- consumed with precipitate CaSO4
-        // Ca++ + SO4-- ---> CaSO4s
-        R[SO4Idx] = -R[CaSO4sIdx];   // (stoichiometric rate)
-        //R[SO4Idx] = R[CaSO4sIdx];  // eq. 55 (confusion rate)
-        // Mg++ consumed with precipitate MgCO3
-        // HCO3- + Mg++ ---> H+ + MgCO3s
-        R[MgIdx] = -R[MgCO3sIdx];  // (stoichiometric rate)
-        //R[MgIdx] = R[MgCO3sIdx]; // eq. 55 (confusion rate)
-
- 
-        TRACE("[H+]=%le, [Ca++]=%le, [HCO3-]=%le, [SO4++] = %le\n",
-            Ct[_H], Ct[_Ca], Ct[_HCO3], Ct[_SO4]);
+        //    R[HIdx] = R[CaCO3sIdx], R[CaIdx] = R[HCO3Idx] = -R[CaCO3sIdx]
+        for (int i=0; i<numKineticSpecies; i++) R[kineticSpecies_[i]] = 0;
+        const reactionNetwork_t &network = networks_[ctx->network];
+        for (int r=0; r<network.numReactions; r++){
+            const kineticReaction_t &reaction = network.reaction[r];
+            for (int s=0; s<reaction.numSpecies; s++)
+                R[reaction.species[s]] -= reaction.nu[s] * R[reaction.mineral];
+        }
         // No reaction rate term for these components:
         R[NaIdx] = 0;
         R[brinePhaseIdx] = 0;
@@ -1026,73 +1193,109 @@ private:
         R[ClIdx] = 0; // Cl- is solved by electroneutrality
 
     }
-    static void solveR(chemicalModel_t *cm){
-        Scalar iS = cm->iS;
+
+    // kineticKernel_(): molal rates f = dy/dt [mol/kg/s] of the kinetic
+    //    species y and, if J is not null, the Jacobian df/dy, for the
+    //    reactions of the network with the gammas of cm held constant.
+    //    Q and R (mol/m3/s) of each reaction are stored in cm->Q, cm->R
+    //    (by reaction letter) and the mineral production in cm->rateC.
+    //    The network is a template parameter, so that the loops over the
+    //    reactions and species are resolved at compile time.
+    template <int n>
+    static void kineticKernel_(const Scalar *y, chemicalModel_t *cm, const Context *ctx,
+                               Scalar *f, Scalar (*J)[numKineticSpecies]){
+        constexpr const reactionNetwork_t &network = networks_[n];
+        for (int i=0; i<numKineticSpecies; i++){
+            f[i] = 0;
+            if (J) for (int j=0; j<numKineticSpecies; j++) J[i][j] = 0;
+        }
+        for (int r=0; r<network.numReactions; r++){
+            const kineticReaction_t &reaction = network.reaction[r];
+            // activity product of species s, without species skip
+            auto product = [&](int skip){
+                Scalar p = 1.0;
+                for (int s=0; s<reaction.numSpecies; s++){
+                    if (s == skip) continue;
+                    const Scalar a = y[kineticIndex_(reaction.species[s])] * GAMMA(reaction.species[s]);
+                    for (int k=0; k<reaction.nu[s]; k++) p *= a;
+                    for (int k=0; k<-reaction.nu[s]; k++) p /= a;
+                }
+                return p;
+            };
+            const Scalar k1 = ctx->k1[reaction.id - 'A'];
+            const Scalar Q = product(-1) / K(ctx, reaction.id);
+            const Scalar R = -k1 * (Q - 1.0);
+            cm->Q[reaction.id - 'A'] = Q;
+            cm->R[reaction.id - 'A'] = R;
+            // Conversion from mol/m3/s --> mol/kg/s
+            cm->rateC[reaction.mineral] = -R / ctx->brineDensity;
+            for (int s=0; s<reaction.numSpecies; s++)
+                f[kineticIndex_(reaction.species[s])] += reaction.nu[s] * R / ctx->brineDensity;
+            if (!J) continue;
+            for (int t=0; t<reaction.numSpecies; t++){
+                const int j = kineticIndex_(reaction.species[t]);
+                // dQ/dy_j = nu_j Q / y_j, or (nu_j = 1, y_j = 0) the other factors
+                Scalar dQ = 0;
+                if (y[j] != 0) dQ = reaction.nu[t] * Q / y[j];
+                else if (reaction.nu[t] == 1) dQ = product(t) * GAMMA(reaction.species[t]) / K(ctx, reaction.id);
+                for (int s=0; s<reaction.numSpecies; s++)
+                    J[kineticIndex_(reaction.species[s])][j] -= reaction.nu[s] * k1 * dQ / ctx->brineDensity;
+            }
+        }
+    }
+
+    // kineticRates(): kernel of the context network. Returns false if the
+    //                 rates (or the Jacobian) are not finite.
+    typedef void (*kineticKernel_t)(const Scalar *, chemicalModel_t *, const Context *,
+                                    Scalar *, Scalar (*)[numKineticSpecies]);
+    template <std::size_t... n>
+    static constexpr std::array<kineticKernel_t, numNetworks> makeKernels_(std::index_sequence<n...>){
+        return {{&kineticKernel_<n>...}};
+    }
+    static bool kineticRates(const Scalar *y, Scalar *f, chemicalModel_t *cm, const Context *ctx,
+                             Scalar (*J)[numKineticSpecies]=nullptr){
+        static constexpr std::array<kineticKernel_t, numNetworks> kernels =
+            makeKernels_(std::make_index_sequence<numNetworks>());
+        kernels[ctx->network](y, cm, ctx, f, J);
+        for (int i=0; i<numKineticSpecies; i++){
+            if (!std::isfinite(f[i])) return false;
+            if (J) for (int j=0; j<numKineticSpecies; j++) if (!std::isfinite(J[i][j])) return false;
+        }
+        return true;
+    }
+
+    static void solveR(chemicalModel_t *cm, Context *ctx){
         double *Ct = cm->molalities;
-        // k1 is in mol/lt/s, but we are working with molalities...
-        //    convert to mol/kg/s:
+        // k1 is in mol/m3/s (molar velocity), as R and Q in cm for VTK.
+        // Internally we work only with molality so rates are converted
+        // to mol/kg/s with the brine density, which comes in DuMuX units
+        // (kg/m3) and is set to the episode input density by the problem.
         //    FIXME(maybe): use actual brine density from partial molar volumes
-        //    see private:ionicStrength()!!!!
         //
-        Scalar QA = ((Ct[_Ca]*GAMMA(_Ca)*Ct[_HCO3]*GAMMA(_HCO3)) / K('A') / Ct[_H]) / GAMMA(_H);
-        Scalar QB = 1.0;
-        Scalar QC = 1.0;
-        Scalar R_A = 0;
-        Scalar R_B = 0;
-        Scalar R_C = 0; 
-
-        R_A = -k1('A') *(QA - 1.0); // Esta es la famosa R_CaCO3 de la ecuacion 50
-        // Pero... la derivada del cambio de densidad del CaCO3 es con signo contrario.
-        //         considerando la fase sólida! Pero esa no nos concierne por ahora.
-        
-#if defined(CACO3_CASO4) || defined(CACO3_CASO4_MGCO3) // Include CaSO4
-        QB = (Ct[_Ca]*GAMMA(_Ca)*Ct[_SO4]*GAMMA(_SO4)) / K('B');
-        R_B = -k1('B') *(QB - 1.0);
-#endif
-#ifdef CACO3_CASO4_MGCO3 // Include  MgCO3
-        QC = (Ct[_Mg]*GAMMA(_Mg)*Ct[_HCO3]*GAMMA(_HCO3)) / K('C') / Ct[_H] / GAMMA(_H);
-        R_C = -k1('C') *(QC - 1.0);
-#endif
-
-	// These will be in original mol/m3/s for VTK.
-        // Units are specified in input file as comment.
-        cm->R[0] = R_A;
-	cm->R[1] = R_B;
-	cm->R[2] = R_C;
-        //  Internally we will work only with molality so rates must be
-        //  converted to mol/kg/s
-        //  Conversion to molal velocity (mol/kg/s) 
-        //  If liter density = 1, we basically have the same thing
-        //  We write out the formula so we can change brineDensity()
-        //  to input density later on.
-        //  brineDensity() is set to episode input density
-        //  in lswf-problem.hh
-        //
-        //  brineDensity() comes in DuMuX units, i.e., kg/m3
-        // Conversion from mol/m3/s --> mol/kg/s
-        R_A /= brineDensity();
-        R_B /= brineDensity();
-        R_C /= brineDensity();
-
+        // Reactions which are not in the network do not proceed.
+        for (int r=0; r<maxKineticReactions; r++){
+            cm->R[r] = 0;
+            cm->Q[r] = 1.0;
+        }
+        cm->rateC[CaCO3sIdx] = 0;
+        cm->rateC[CaSO4sIdx] = 0;
+        cm->rateC[MgCO3sIdx] = 0;
         // Independent rates: (positive values indicate production)
-        // Production in solid phase, nothinTRACEg is in aqueous phase
-        cm->rateC[CaCO3sIdx] = -R_A;
-        cm->rateC[CaSO4sIdx] = -R_B;
-        cm->rateC[MgCO3sIdx] = -R_C;
+        // Production in solid phase, nothing is in aqueous phase
+        Scalar y[numKineticSpecies], f[numKineticSpecies];
+        for (int i=0; i<numKineticSpecies; i++) y[i] = Ct[kineticSpecies_[i]];
+        kineticRates(y, f, cm, ctx);
 
 #ifndef SIMPLIFIED
         // Reaction rates cannot contradict equilibrium equation:
-        checkReactionRateConsistency(cm);
+        checkReactionRateConsistency(cm, ctx);
 #endif
         // Dependent rates:
-        solveDependentRates(cm);
-        cm->Q[0] = QA;
-        cm->Q[1] = QB;
-        cm->Q[2] = QC;
-        TRACE("Ca=%le SO4=%le 1-x, x= %le --> -cm->rateC[CaIdx] is: %le\n",Ct[_Ca], Ct[_SO4], (Ct[_Ca]*Ct[_SO4]) / K('B'),  R[CaIdx]);
+        solveDependentRates(cm, ctx);
+        TRACE("Ca=%le SO4=%le QB= %le --> cm->rateC[CaIdx] is: %le\n",Ct[_Ca], Ct[_SO4], cm->Q[1], cm->rateC[CaIdx]);
     }
 
-    static void adjustVanishedReactant(Scalar timeStepSize, chemicalModel_t *cm){
+    static void adjustVanishedReactant(Scalar timeStepSize, chemicalModel_t *cm, Context *ctx){
         double *Ct = cm->molalities;
         // If any concentration is below zero, we must adjust R.
         bool zeroed;
@@ -1105,7 +1308,7 @@ private:
                 cm->rateC[CaCO3sIdx] /= 10.0;
                 cm->rateC[MgCO3sIdx] /= 10.0;
                 // Recalculate dependent reaction rates:
-                solveDependentRates(cm);
+                solveDependentRates(cm, ctx);
                 // continue in the loop:
                 zeroed = true;
                 continue;
@@ -1114,7 +1317,7 @@ private:
                 DBG("*** Ca++ is zeroed...(precipitating CaCO3 or CaSO4)\n");
                 cm->rateC[CaCO3sIdx] /= 10.0;
                 cm->rateC[CaSO4sIdx] /= 10.0;
-                solveDependentRates(cm);
+                solveDependentRates(cm, ctx);
                 zeroed = true;
                 continue;
             }
@@ -1122,7 +1325,7 @@ private:
                 DBG("*** Mg is zeroed...(precipitating MgCO3) cm->rateC[MgIdx]%le, cm->rateC[MgIdx] * timeStepSize = %le, Ct[_Mg] = %le\n",
                         cm->rateC[MgIdx],  cm->rateC[MgIdx] * timeStepSize, Ct[_Mg]);
                 cm->rateC[MgCO3sIdx] /= 10.0;
-                solveDependentRates(cm);
+                solveDependentRates(cm, ctx);
                 zeroed = true;
                 exit(1);
                 continue;
@@ -1132,7 +1335,7 @@ private:
                       cm->rateC[CaCO3sIdx], cm->rateC[CaCO3sIdx]/10.0,  cm->rateC[MgCO3sIdx],  cm->rateC[MgCO3sIdx]/10.0);
                 cm->rateC[CaCO3sIdx] /= 10.0;
                 cm->rateC[MgCO3sIdx] /= 10.0;
-                solveDependentRates(cm);
+                solveDependentRates(cm, ctx);
                 zeroed = true;
                 continue;
                 //exit(1);
@@ -1149,7 +1352,7 @@ private:
                 DBG("*** _CaSO4s is zeroed...cm->rateC[CaSO4sIdx]=%le, cm->rateC[CaSO4sIdx] * timeStepSize = %le, Ct[_CaSO4s] = %le\n",
                         cm->rateC[CaSO4sIdx],  cm->rateC[CaSO4sIdx] * timeStepSize, Ct[_CaSO4s]);
                 cm->rateC[CaSO4sIdx] /= 10;
-                solveDependentRates(cm);
+                solveDependentRates(cm, ctx);
                 zeroed = true;
                 exit(1);
                 continue;
@@ -1159,7 +1362,7 @@ private:
                 DBG("*** SO4 is zeroed...(precipitating CaSO4) cm->rateC[SO4Idx]=%le, cm->rateC[SO4Idx] * timeStepSize = %le, Ct[_SO4] = %le\n",
                         cm->rateC[SO4Idx],  cm->rateC[SO4Idx] * timeStepSize, Ct[_SO4]);
                 cm->rateC[CaSO4sIdx] /= 10;
-                solveDependentRates(cm);
+                solveDependentRates(cm, ctx);
                 zeroed = true;
                 //exit(1);
                 continue;
@@ -1168,17 +1371,16 @@ private:
     }
 
     // Check all transport component concentrations positive.
-    static bool checkAllPositive(chemicalModel_t *cm){
+    static bool checkAllPositive(chemicalModel_t *cm, Context *ctx){
         bool result = true;
         double *Ct = cm->molalities;
-        static int warned=0;
         for (int compIdx=numMajorComponents; compIdx < numComponents; compIdx++) {
             if (Ct[compIdx] < 0){
                     DBG("*******************************checkEquilibrium*******************************\n");
                     DBG("*******   transport provides component %s concentration negative!   ********\n", name(compIdx).c_str());
                     DBG("*******   Chemical model will use a small concentration instead.    ********\n", name(compIdx).c_str());
                     DBG("*************************************************************************\n");
-                    warned = true;
+                    ctx->warned++;
                     result = false;
 #ifndef DEBUG
                 Ct[compIdx] = 0.0001;
@@ -1189,24 +1391,24 @@ private:
     }
 
     // Second equilibrium may or may not use solved ODE's
-    static bool checkEquilibrium(chemicalModel_t *cm){
-        bool result = checkAllPositive(cm);
+    static bool checkEquilibrium(chemicalModel_t *cm, Context *ctx){
+        bool result = checkAllPositive(cm, ctx);
         double *Ct = cm->molalities;
         double iS = cm->iS;
 
 
 #ifdef DEBUG
         Scalar eq[numComponents];
-        eq[_Ca] = K('A')*Ct[_H] * GAMMA(_H) / Ct[_HCO3] / GAMMA(_HCO3) / GAMMA(_Ca);
-        eq[_H]  = K('F')*Ct[_HCO3] * GAMMA(_HCO3) / Ct[_CO3] / GAMMA(_CO3) / GAMMA(_H);
-        eq[_HCO3] = K('A')*Ct[_H] * GAMMA(_H) / Ct[_Ca] / GAMMA(_Ca)/ GAMMA(_HCO3);
-        eq[_SO4] = K('B') / Ct[_Ca] / GAMMA(_Ca) / GAMMA(_SO4);
-        eq[_Mg] =  K('C')*Ct[_H] * GAMMA(_H) / Ct[_HCO3] / GAMMA(_HCO3) / GAMMA(_Mg);
+        eq[_Ca] = K(ctx, 'A')*Ct[_H] * GAMMA(_H) / Ct[_HCO3] / GAMMA(_HCO3) / GAMMA(_Ca);
+        eq[_H]  = K(ctx, 'F')*Ct[_HCO3] * GAMMA(_HCO3) / Ct[_CO3] / GAMMA(_CO3) / GAMMA(_H);
+        eq[_HCO3] = K(ctx, 'A')*Ct[_H] * GAMMA(_H) / Ct[_Ca] / GAMMA(_Ca)/ GAMMA(_HCO3);
+        eq[_SO4] = K(ctx, 'B') / Ct[_Ca] / GAMMA(_Ca) / GAMMA(_SO4);
+        eq[_Mg] =  K(ctx, 'C')*Ct[_H] * GAMMA(_H) / Ct[_HCO3] / GAMMA(_HCO3) / GAMMA(_Mg);
 
         // negative concentrations are not valid.
                  
         TRACE("log/K_A: %le/%le, log/K_F; %le/%le; log/K_B: %le/%le; log/K_C: %le/%le\n",
-                    logK('A'),K('A'), logK('F'), K('F'), logK('B'), K('B'), logK('C'), K('C'));
+                    logK('A'),K(ctx, 'A'), logK('F'), K(ctx, 'F'), logK('B'), K(ctx, 'B'), logK('C'), K(ctx, 'C'));
    
         if (!result){
             DBG("checkEquilibrium: ionic strength=%le\n", cm->iS);
@@ -1227,7 +1429,11 @@ private:
 
     // solveODEs(): solves ordinary differential equations which define concentration change in
     //              time interval (depends on reaction rate constants).
-    static void solveODEs(Scalar timeStepSize, chemicalModel_t *cm){
+    //              A negative time step skips the ODE's.
+    static void solveODEs(Scalar timeStepSize, chemicalModel_t *cm, Context *ctx,
+                          speciationStatus_t *status=nullptr){
+        if (!(timeStepSize > 0)) return;
+#ifdef EXPLICIT_ODES
         double *Ct = cm->molalities;
         double iS = cm->iS;
         TRACE("solveODEs timestep %lf\n", timeStepSize);
@@ -1243,7 +1449,7 @@ private:
         // Solutes
         DBG("solveODEs concentration/activity: Ca=%le/%le H=%le/%le, HCO3=%le/%le, SO4=%le/%le\n",
                 Ct[_Ca], GAMMA(_Ca), Ct[_H], GAMMA(_H), Ct[_HCO3], GAMMA(_HCO3), Ct[_SO4], GAMMA(_SO4));
-        adjustVanishedReactant(timeStepSize, cm);
+        adjustVanishedReactant(timeStepSize, cm, ctx);
         // R values are now adjusted to zero concentrations
         // Integration proceeds from concentration, no GAMMA here
         // since no equilibrium constants are involved.
@@ -1260,19 +1466,135 @@ private:
                 Ct[_Ca], GAMMA(_Ca), Ct[_H], GAMMA(_H), Ct[_HCO3], GAMMA(_HCO3), Ct[_SO4], GAMMA(_SO4));
            
 
+#else
+        if (!integrateKinetics(timeStepSize, cm, ctx, status) && status) status->converged = false;
+#endif
         return;
     }
-    // solveIonicStrength(): internal iterative function to solve ionic strength.
-    static Scalar solveIonicStrength(chemicalModel_t *cm){
+
+    // integrateKinetics(): ROS2 (Verwer et al., 1999), L-stable and of second
+    //    order, with W = I - gamma*h*J and the Jacobian J of the network kernel:
+    //
+    //    W k1 = f(y)
+    //    W k2 = f(y + h k1) - 2 k1
+    //    y' = y + 3/2 h k1 + 1/2 h k2
+    //
+    //    The error is estimated against the embedded linearly implicit Euler
+    //    step y + h k1. Rejected substeps (error above odeTolerance, negative
+    //    or non finite concentrations) are retried with a smaller h. The first
+    //    substep tries the whole time step. Returns false when the substeps
+    //    exceed maxOdeSubsteps or h vanishes; cm then holds the concentrations
+    //    at the last accepted substep.
+    //    The state are the kinetic species; solid concentrations are constant
+    //    (see the explicit update).
+    static bool integrateKinetics(Scalar timeStepSize, chemicalModel_t *cm, Context *ctx,
+                                  speciationStatus_t *status){
+        const int n = numKineticSpecies;
+        const Scalar gamma = 1.0 + 1.0/std::sqrt(2.0);
+        Scalar y[n], y1[n], f0[n], k1[n], k2[n], yStage[n];
+        Scalar J[n][n], W[n][n];
+        int pivot[n];
+        for (int i=0; i<n; i++) y[i] = cm->molalities[kineticSpecies_[i]];
+
+        Scalar t = 0;
+        Scalar h = timeStepSize;
+        int substeps = 0;
+        int rejected = 0;
+        bool ok = true;
+        while (t < timeStepSize) {
+            if (substeps + rejected >= maxOdeSubsteps || h < 1e-12*timeStepSize) {
+                DBG("Ions::integrateKinetics(): stopped at t=%le of %le (%d substeps, %d rejected)\n",
+                        t, timeStepSize, substeps, rejected);
+                ok = false;
+                break;
+            }
+            const bool last = (h >= timeStepSize - t);
+            if (last) h = timeStepSize - t;
+            if (!kineticRates(y, f0, cm, ctx, J)) { ok = false; break; }
+            for (int i=0; i<n; i++)
+                for (int j=0; j<n; j++) W[i][j] = ((i == j)? 1.0 : 0.0) - gamma*h*J[i][j];
+            if (!luDecompose_(W, pivot)) { h *= 0.25; rejected++; continue; }
+
+            for (int i=0; i<n; i++) k1[i] = f0[i];
+            luSolve_(W, pivot, k1);
+            for (int i=0; i<n; i++) yStage[i] = y[i] + h*k1[i];
+            bool accept = kineticRates(yStage, k2, cm, ctx);
+            Scalar errorNorm = 0;
+            if (accept) {
+                for (int i=0; i<n; i++) k2[i] -= 2.0*k1[i];
+                luSolve_(W, pivot, k2);
+                for (int i=0; i<n; i++){
+                    y1[i] = y[i] + 1.5*h*k1[i] + 0.5*h*k2[i];
+                    if (!(y1[i] >= 0)) accept = false;
+                    Scalar scale = odeAbsTolerance + odeTolerance*std::max(std::fabs(y[i]), std::fabs(y1[i]));
+                    errorNorm = std::max(errorNorm, std::fabs(0.5*h*(k1[i] + k2[i]))/scale);
+                }
+                if (errorNorm > 1.0) accept = false;
+            }
+            // first order error estimate: h ~ error^(-1/2)
+            Scalar factor = (std::isfinite(errorNorm))?
+                0.9/std::sqrt(std::max(errorNorm, 1e-4)) : 0.25;
+            if (accept) {
+                t = (last)? timeStepSize : t + h;
+                for (int i=0; i<n; i++) y[i] = y1[i];
+                substeps++;
+                h *= std::min(factor, 5.0);
+            } else {
+                rejected++;
+                h *= std::max(std::min(factor, 0.5), 0.1);
+            }
+        }
+        for (int i=0; i<n; i++) cm->molalities[kineticSpecies_[i]] = y[i];
+        if (status) {
+            status->odeSubsteps += substeps;
+            status->odeRejected += rejected;
+        }
+        return ok;
+    }
+
+    // luDecompose_(), luSolve_(): dense LU with partial pivoting for W.
+    static bool luDecompose_(Scalar (*W)[numKineticSpecies], int *pivot){
+        const int n = numKineticSpecies;
+        for (int k=0; k<n; k++){
+            int p = k;
+            for (int i=k+1; i<n; i++) if (std::fabs(W[i][k]) > std::fabs(W[p][k])) p = i;
+            if (!(std::fabs(W[p][k]) > 0)) return false;
+            pivot[k] = p;
+            if (p != k) for (int j=0; j<n; j++) std::swap(W[k][j], W[p][j]);
+            for (int i=k+1; i<n; i++){
+                W[i][k] /= W[k][k];
+                for (int j=k+1; j<n; j++) W[i][j] -= W[i][k]*W[k][j];
+            }
+        }
+        return true;
+    }
+    static void luSolve_(Scalar (*W)[numKineticSpecies], const int *pivot, Scalar *b){
+        const int n = numKineticSpecies;
+        for (int k=0; k<n; k++) std::swap(b[k], b[pivot[k]]);
+        for (int k=0; k<n; k++)
+            for (int i=k+1; i<n; i++) b[i] -= W[i][k]*b[k];
+        for (int k=n-1; k>=0; k--){
+            for (int j=k+1; j<n; j++) b[k] -= W[k][j]*b[j];
+            b[k] /= W[k][k];
+        }
+    }
+
+    // solveIonicStrength(): internal iterative function to solve ionic strength
+    //                       (fixed point, used with FIXED_POINT_SPECIATION).
+    static Scalar solveIonicStrength(chemicalModel_t *cm, Context *ctx, speciationStatus_t *status=nullptr){
         // Now solve all concentrations and recalculate iS
         // for timestep concentration.
         Scalar newIS;
         Scalar criteria;
         int count=0;
         do {
-            solveEquilibrium(cm); // equilibriums (fast reactions, depends on iS)
+            if (count >= maxSpeciationIterations) {
+                if (status) status->converged = false;
+                break;
+            }
+            solveEquilibrium(cm, ctx); // equilibriums (fast reactions, depends on iS)
 #ifdef SOLVE_CL
-            cm->molalities[_Cl] = solveCl(cm); // by electroneutrality
+            cm->molalities[_Cl] = solveCl(cm, ctx); // by electroneutrality
 #endif
             newIS=getIonicStrength(cm);
             criteria = fabs((newIS - cm->iS)/cm->iS)*100;
@@ -1281,12 +1603,78 @@ private:
             TRACE("solveIonicStrength(): newStrength at iteration %d (%s): %lf criteria = %lf\n",
                     count, iS<0?"ideal":"activities", iS, criteria);
 
-        } while (fabs(criteria > 0.1)); // changes less than 0.1%
+        } while (criteria > 0.1); // changes less than 0.1%
+        if (status) {
+            status->iterations += count;
+            status->residual = criteria/100;
+        }
         TRACE("** intermediate iS=%le\n", newIS);
         return newIS;
     }
 
-    static Scalar solveReactionRates(Scalar timeStepSize, chemicalModel_t *cm){
+    // solveSpeciation(): Newton-Raphson solution of the coupled ionic strength,
+    //                    mass action and electroneutrality system.
+    //
+    //    F1 = iS - I([Cl])          (ionic strength definition)
+    //    F2 = [Cl] - Cl_EN(iS)      (electroneutrality, SOLVE_CL only)
+    //
+    // The equilibrium (mass action) species are explicit functions of iS
+    // through the activity coeficients, so the Jacobian is obtained
+    // analytically from dln(gamma)/dI. On return, cm->iS, gammas and the
+    // equilibrium concentrations are consistent. Iterations are capped
+    // by maxSpeciationIterations.
+    static speciationStatus_t solveSpeciation(chemicalModel_t *cm, Context *ctx){
+        speciationStatus_t status = {false, 0, 0, 0.0, 0, 0};
+        double *Ct = cm->molalities;
+        // dI/d[Cl]: Cl- contributes to the ionic strength with ALL_IONS_FOR_IS
+        Scalar dIS_dCl = 0;
+#if defined(ALL_IONS_FOR_IS) && defined(SOLVE_CL)
+        dIS_dCl = 0.5 * componentTable_.p[_Cl].isWeight;
+#endif
+        if (!(cm->iS > 0)) cm->iS = getIonicStrength(cm);
+
+        while (status.iterations < maxSpeciationIterations) {
+            status.iterations++;
+            calculateGammas(cm, ctx);
+            solveEquilibrium(cm, ctx);
+            Scalar dCl_dIS = 0;
+#ifdef SOLVE_CL
+            Scalar Cl = solveCl(cm, ctx, &dCl_dIS);
+#else
+            Scalar Cl = Ct[_Cl];
+#endif
+            Scalar F1 = cm->iS - getIonicStrength(cm);
+            Scalar F2 = Ct[_Cl] - Cl;
+            status.residual = std::max(fabs(F1) / cm->iS,
+                                       Cl > 0 ? fabs(F2) / Cl : fabs(F2));
+            if (!std::isfinite(status.residual)) {
+                DBG("Ions::solveSpeciation(): non finite residual at iteration %d\n", status.iterations);
+                return status;
+            }
+            if (status.residual < speciationTolerance) {
+                status.converged = true;
+                return status;
+            }
+            // J = [[1, -dI/dCl], [-dCl/dI, 1]]
+            Scalar det = 1 - dIS_dCl * dCl_dIS;
+            if (fabs(det) < 1e-14) {
+                DBG("Ions::solveSpeciation(): singular Jacobian at iteration %d\n", status.iterations);
+                return status;
+            }
+            Scalar deltaIS = -(F1 + dIS_dCl * F2) / det;
+            Scalar deltaCl = -(F2 + dCl_dIS * F1) / det;
+            // keep ionic strength positive and Cl non negative
+            cm->iS = (cm->iS + deltaIS > 0) ? cm->iS + deltaIS : 0.5 * cm->iS;
+            Ct[_Cl] = (Ct[_Cl] + deltaCl >= 0) ? Ct[_Cl] + deltaCl : 0.5 * Ct[_Cl];
+        }
+        // not converged: leave a consistent state at the last iterate
+        calculateGammas(cm, ctx);
+        solveEquilibrium(cm, ctx);
+        return status;
+    }
+
+    static Scalar solveReactionRates(Scalar timeStepSize, chemicalModel_t *cm, Context *ctx,
+                                     speciationStatus_t *status=nullptr){
         // Get reaction rates:
         // To solve R we need Ct values.
         // We input initial concentrations for Ct
@@ -1296,22 +1684,31 @@ private:
         double molalities[allComponents];
         memcpy(molalities, cm->molalities, allComponents*sizeof(double));
         do {
+            if (count >= maxReactionRateIterations) {
+                if (status) status->converged = false;
+                break;
+            }
             count++;
             memcpy(cm->molalities, molalities, allComponents*sizeof(double));
-            solveR(cm);
+            solveR(cm, ctx);
 #ifndef SOLVE_ODES
 # warning "not solving Ct from ODEs"
 #else
-            solveODEs(timeStepSize, cm);
+            solveODEs(timeStepSize, cm, ctx, status);
+            // the change of this pass, the speciation below may shift
+            // the kinetic species as well
+            if (status)
+                for (int i=0; i<numKineticSpecies; i++)
+                    status->kineticChange[i] = cm->molalities[kineticSpecies_[i]] - molalities[kineticSpecies_[i]];
 #endif
-            if (!checkEquilibrium(cm)){
+            if (!checkEquilibrium(cm, ctx)){
             /*    DBG("!checkEquilibrium on pass %d\n", count);
-                newIS = solveIonicStrength(cm);
+                newIS = solveIonicStrength(cm, ctx);
                 criteria = fabs((newIS - cm->iS)/cm->iS)*100;
                 DBG("old iS=%lf, new iS=%lf\n", cm->iS, newIS);
                 cm->iS = newIS;
                 // recalculate gammas with new iS
-                calculateGammas(cm);
+                calculateGammas(cm, ctx);
                 DBG(" solveReactionRates: Ca--> gamma=%lf, [Ca]=%lf QA=%lf QB=%lf QC=%lf\n",
                     cm->gamma[_Ca], cm->molalities[_Ca], cm->Q[0], cm->Q[1], cm->Q[2]);
 
@@ -1321,11 +1718,26 @@ private:
 #if 10
 #ifdef USE_ACTIVITY_COEFICIENTS
 
-            newIS = solveIonicStrength(cm);
+#ifndef FIXED_POINT_SPECIATION
+            Scalar oldIS = cm->iS;
+            speciationStatus_t speciation = solveSpeciation(cm, ctx);
+            if (status) {
+                status->iterations += speciation.iterations;
+                status->residual = speciation.residual;
+                if (!speciation.converged) status->converged = false;
+            }
+            newIS = cm->iS;
+            criteria = fabs((newIS - oldIS)/oldIS)*100;
+            // no speciation at these concentrations (e.g. beyond the
+            // range of the activity model), further passes cannot help
+            if (!speciation.converged) break;
+#else
+            newIS = solveIonicStrength(cm, ctx, status);
             criteria = fabs((newIS - cm->iS)/cm->iS)*100;
             cm->iS = newIS;
             // recalculate gammas with new iS
-            calculateGammas(cm);
+            calculateGammas(cm, ctx);
+#endif
             TRACE(" solveReactionRates: Ca--> gamma=%lf, [Ca]=%lf QA=%lf QB=%lf QC=%lf\n",
                 cm->gamma[_Ca], cm->molalities[_Ca], cm->Q[0], cm->Q[1], cm->Q[2]);
             TRACE("solveReactionRates()2: newIStrength at iteration %d (%s): %lf criteria = %lf\n",
@@ -1335,7 +1747,8 @@ private:
             break;
 #endif
 #endif
-        } while (fabs(criteria > 0.1)); // changes less than 0.1%
+        } while (criteria > 0.1); // changes less than 0.1%
+        if (status) status->outerIterations += count;
         return newIS;
     }
 
@@ -1354,5 +1767,8 @@ public:
 
 };
 
+template <class Scalar>
+constexpr typename Ions<Scalar>::componentTable_t Ions<Scalar>::componentTable_ = Ions<Scalar>::makeComponentTable_();
+
 }// end namespace Dumux
 #endif
@@ -0,0 +1,241 @@
+/**************************************************************************
+ *  Copyright 2018 Instituto Mexicano del Petroleo
+ *
+ *     All rights reserved for internal usage
+ *     (If distributed to third parties,
+ *      please note DuMux opensource restrictions)
+ *
+ *  File(s):
+ *              chemical/ionscache.hh
+ *              chemical/ions.hh
+ *
+ *  Description:
+ *
+ *     Cache of speciation results in front of Ions::ionicStrength().
+ *     Ahead of the injection front and behind it the brine composition
+ *     is uniform over large regions, so that the same speciation would
+ *     be solved again for many cells.
+ *
+ *     The key is the composition quantized with a relative tolerance:
+ *     each transported molality m is replaced by the integer
+ *     k = round(log(m)/log(1+tolerance)), so that compositions which
+ *     differ less than the tolerance (relative) share the key. The
+ *     temperature, time step, brine density, rate constants and reaction
+ *     network of the context are part of the key as they are. The ionic
+ *     strength guess cm->iS is not: the solver starts from the ionic
+ *     strength of the molalities.
+ *
+ *     The cached result of a key is the speciation solved at the center
+ *     of its bin, the molalities (1+tolerance)^k (zero and negative
+ *     molalities are bins of their own, solved as zero and as corrected
+ *     by the solver). It therefore depends on the key only, not on the
+ *     order in which cells reach the cache nor on the thread schedule.
+ *     A lookup copies the result of the center (gammas, rateC, R, Q,
+ *     the kinetic change of the status, ...) without iterating, and the transported molalities are shifted
+ *     by the difference between the query and the center, which is less
+ *     than tolerance/2 (relative). Only converged results are cached.
+ *
+ *     The cache is split in shards, each with its own lock, to be used
+ *     from all threads of the chemistry step. A shard which reaches its
+ *     capacity is emptied.
+ *
+ ***************************************************************************/
+#ifndef LSWF_IONS_CACHE_HH
+#define LSWF_IONS_CACHE_HH
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "ions.hh"
+
+namespace Dumux
+{
+template <class Scalar>
+class IonsCache
+{
+public:
+    typedef Dumux::Ions<Scalar> Ions;
+    typedef typename Ions::Context Context;
+
+    // tolerance: relative tolerance of the molalities sharing a key
+    // capacity: maximum number of results kept
+    IonsCache(Scalar tolerance=1e-6, std::size_t capacity=1<<16, int numShards=64):
+        logBase_(std::log1p(tolerance)),
+        shards_(new Shard[numShards]),
+        numShards_(numShards),
+        shardCapacity_(std::max<std::size_t>(1, capacity/numShards)),
+        hits_(0),
+        misses_(0)
+    {
+        if (!(tolerance > 0)) {
+            DUNE_THROW(Dune::InvalidStateException, "IonsCache: tolerance must be positive " << tolerance);
+        }
+    }
+
+#ifndef SIMPLIFIED
+    // ionicStrength(): Ions::ionicStrength() with cached results.
+    Scalar ionicStrength(Scalar timeStepSize, chemicalModel_t *cm, Context *ctx,
+                         speciationStatus_t *status=nullptr){
+#else
+    Scalar ionicStrength(Scalar timeStepSize, chemicalModel_t *cm, Context *ctx){
+#endif
+        const key_t key = makeKey_(timeStepSize, cm, ctx);
+        const std::size_t hash = key_hash()(key);
+        Shard &shard = shards_[hash % numShards_];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.map.find(key);
+            if (it != shard.map.end()) {
+                copyFromCenter_(key, it->second.cm, cm);
+#ifndef SIMPLIFIED
+                if (status) {
+                    *status = {true, 0, 0, 0.0, 0, 0};
+                    std::memcpy(status->kineticChange, it->second.kineticChange, sizeof(status->kineticChange));
+                }
+#endif
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return cm->iS;
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+
+        entry_t center;
+        center.cm = *cm;
+        setCenter_(key, &center.cm);
+#ifndef SIMPLIFIED
+        speciationStatus_t localStatus;
+        if (!status) status = &localStatus;
+        Ions::ionicStrength(timeStepSize, &center.cm, ctx, status);
+        std::memcpy(center.kineticChange, status->kineticChange, sizeof(center.kineticChange));
+        if (status->converged)
+#else
+        Ions::ionicStrength(timeStepSize, &center.cm, ctx);
+        std::memset(center.kineticChange, 0, sizeof(center.kineticChange));
+#endif
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (shard.map.size() >= shardCapacity_) shard.map.clear();
+            // a result of the same key stored meanwhile is the same
+            shard.map.emplace(key, center);
+        }
+        copyFromCenter_(key, center.cm, cm);
+        return cm->iS;
+    }
+
+    long hits(void) const {return hits_.load(std::memory_order_relaxed);}
+    long misses(void) const {return misses_.load(std::memory_order_relaxed);}
+    Scalar hitRate(void) const {
+        long lookups = hits() + misses();
+        return (lookups)? (Scalar)hits()/lookups : 0.0;
+    }
+
+    void clear(void){
+        for (int i=0; i<numShards_; i++){
+            std::lock_guard<std::mutex> lock(shards_[i].mutex);
+            shards_[i].map.clear();
+        }
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+private:
+    // quantized molalities, then the context values (bitwise)
+    static const int numContextValues = 7;
+    typedef std::array<std::int64_t, Ions::numIons + numContextValues> key_t;
+
+    struct key_hash {
+        std::size_t operator()(const key_t &key) const {
+            std::uint64_t h = 14695981039346656037ull; // FNV-1a over the words
+            for (auto word : key){
+                h ^= (std::uint64_t)word;
+                h *= 1099511628211ull;
+            }
+            return (std::size_t)(h ^ (h >> 32));
+        }
+    };
+
+    // result of the bin center
+    typedef struct entry_t {
+        chemicalModel_t cm;
+        double kineticChange[Ions::numKineticSpecies];
+    } entry_t;
+
+    typedef struct Shard {
+        std::mutex mutex;
+        std::unordered_map<key_t, entry_t, key_hash> map;
+    } Shard;
+
+    static std::int64_t bits_(Scalar value){
+        double d = value;
+        std::int64_t word;
+        std::memcpy(&word, &d, sizeof(word));
+        return word;
+    }
+
+    // zero and negative (corrected by the solver) molalities have keys
+    // of their own
+    static const std::int64_t zeroKey = INT64_MIN;
+    static const std::int64_t negativeKey = INT64_MIN + 1;
+
+    key_t makeKey_(Scalar timeStepSize, const chemicalModel_t *cm, const Context *ctx) const {
+        key_t key;
+        for (int i=0; i<Ions::numIons; i++){
+            Scalar m = cm->molalities[Ions::numPhases + i];
+            key[i] = (m > 0)? (std::int64_t)std::llround(std::log(m)/logBase_) :
+                              ((m == 0)? zeroKey : negativeKey);
+        }
+        key[Ions::numIons + 0] = bits_(ctx->temperature);
+        key[Ions::numIons + 1] = bits_(timeStepSize);
+        key[Ions::numIons + 2] = bits_(ctx->brineDensity);
+        key[Ions::numIons + 3] = bits_(ctx->k1[0]);
+        key[Ions::numIons + 4] = bits_(ctx->k1[1]);
+        key[Ions::numIons + 5] = bits_(ctx->k1[2]);
+        key[Ions::numIons + 6] = ctx->network;
+        return key;
+    }
+
+    // molality at the center of the bin of a key word
+    Scalar center_(std::int64_t word) const {
+        if (word == zeroKey) return 0.0;
+        // any negative value, the solver replaces it (checkAllPositive())
+        if (word == negativeKey) return -1.0;
+        return std::exp(word*logBase_);
+    }
+
+    // setCenter_(): transported molalities of cm at the center of the bin.
+    void setCenter_(const key_t &key, chemicalModel_t *cm) const {
+        for (int i=0; i<Ions::numIons; i++)
+            cm->molalities[Ions::numPhases + i] = center_(key[i]);
+    }
+
+    // copyFromCenter_(): result of the center for the query cm, with the
+    //                    transported molalities shifted to those of cm.
+    void copyFromCenter_(const key_t &key, const chemicalModel_t &center, chemicalModel_t *cm) const {
+        Scalar shift[Ions::numIons];
+        for (int i=0; i<Ions::numIons; i++){
+            const Scalar m = cm->molalities[Ions::numPhases + i];
+            shift[i] = (m > 0)? m - center_(key[i]) : 0.0;
+        }
+        *cm = center;
+        for (int i=0; i<Ions::numIons; i++)
+            cm->molalities[Ions::numPhases + i] += shift[i];
+    }
+
+    Scalar logBase_;
+    std::unique_ptr<Shard[]> shards_;
+    int numShards_;
+    std::size_t shardCapacity_;
+    std::atomic<long> hits_;
+    std::atomic<long> misses_;
+};
+
+} // end namespace Dumux
+
+#endif
@@ -0,0 +1,557 @@
+/**************************************************************************
+ *  Copyright 2018 Instituto Mexicano del Petroleo
+ *
+ *     All rights reserved for internal usage
+ *     (If distributed to third parties,
+ *      please note DuMux opensource restrictions)
+ *
+ *  File(s):
+ *              chemical/ionstable.hh
+ *              chemical/ions.hh
+ *
+ *  Description:
+ *
+ *     Precomputed speciation table (surrogate of Ions::ionicStrength()).
+ *
+ *     The result of the chemical model (ionic strength, speciated
+ *     molalities, gammas and rateC) is a smooth function of a few
+ *     transported molalities when the others are fixed. build() samples
+ *     the solver over a box of those molalities (log10 scale) and
+ *     refines it as a kd-tree: a box is split in half along its widest
+ *     direction while the multilinear interpolation of its corners
+ *     differs from the solver at the box center by more than the
+ *     (relative) tolerance, down to 2^maxLevel cells per direction.
+ *     Corners are shared between neighbour boxes. Inside a box the
+ *     interpolation is multilinear in the molalities (not in their
+ *     logarithm), so that the table ions themselves are exact.
+ *
+ *     interpolate() looks up the leaf of a composition and fills the
+ *     chemicalModel_t from its corners. It returns false (the caller
+ *     then uses the solver) outside the table domain, when the fixed
+ *     molalities or the context do not match the table, or when a corner
+ *     did not converge. The results do not depend on the time step and
+ *     the brine density (rateC is returned by Ions::ionicStrength() in
+ *     mol/m3 brine/s, which does not depend on it, see chemicalmodel.hh),
+ *     so only temperature, rate constants and reaction network have to
+ *     match.
+ *
+ *     With SOLVE_ODES the result is integrated over the time step, a
+ *     table would only apply to the step size it was built with, which
+ *     adaptive time stepping does not repeat. The table is therefore not
+ *     available then: build() and read() throw.
+ *
+ *     write()/read() store the table in a compact binary file. read()
+ *     throws if the table was built for another context (temperature,
+ *     rate constants, network) or other fixed molalities than those of
+ *     the run, instead of falling back to the solver on every lookup.
+ *
+ ***************************************************************************/
+#ifndef LSWF_IONS_TABLE_HH
+#define LSWF_IONS_TABLE_HH
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ions.hh"
+
+namespace Dumux
+{
+template <class Scalar>
+class IonsTable
+{
+public:
+    typedef Dumux::Ions<Scalar> Ions;
+    typedef typename Ions::Context Context;
+
+    static const int maxDimension = 8;
+    // rateC is set up to the last solid
+    static const int numRates = Ions::MgCO3sIdx + 1;
+    // iS, molalities, gammas, rateC
+    static const int numOutputs = 1 + 2*Ions::allComponents + numRates;
+
+    IonsTable(): dimension_(0), lookups_(0), hits_(0) {}
+
+    bool empty(void) const {return nodes_.empty();}
+    int dimension(void) const {return dimension_;}
+    // ion (component index) of table direction i
+    int ion(int i) const {return ions_[i];}
+    std::size_t leaves(void) const {return numLeaves_;}
+    std::size_t samples(void) const {return samples_.size()/numOutputs;}
+    long lookups(void) const {return lookups_.load(std::memory_order_relaxed);}
+    long hits(void) const {return hits_.load(std::memory_order_relaxed);}
+
+    // build(): sample the solver over lower[i] <= m[ions[i]] <= upper[i]
+    //          (molalities), with the other molalities as in base.
+    void build(const Context *ctx, Scalar timeStepSize,
+               const std::vector<int> &ions,
+               const std::vector<Scalar> &lower, const std::vector<Scalar> &upper,
+               const chemicalModel_t *base, Scalar tolerance, int maxLevel){
+        checkAvailable_();
+        dimension_ = ions.size();
+        if (dimension_ < 1 || dimension_ > maxDimension
+            || lower.size() != ions.size() || upper.size() != ions.size()) {
+            DUNE_THROW(Dune::InvalidStateException, "IonsTable: " << ions.size()
+                       << " ions (1.." << maxDimension << ") with "
+                       << lower.size() << " lower and " << upper.size() << " upper bounds");
+        }
+        if (maxLevel < 1 || maxLevel > 20) {
+            DUNE_THROW(Dune::InvalidStateException, "IonsTable: maxLevel " << maxLevel << " not in 1..20");
+        }
+        ions_ = ions;
+        logLower_.resize(dimension_);
+        logUpper_.resize(dimension_);
+        for (int i=0; i<dimension_; i++){
+            if (!(lower[i] > 0 && upper[i] > lower[i])) {
+                DUNE_THROW(Dune::InvalidStateException, "IonsTable: invalid range of "
+                           << Ions::name(ions[i]) << ": " << lower[i] << ".." << upper[i]);
+            }
+            logLower_[i] = std::log10(lower[i]);
+            logUpper_[i] = std::log10(upper[i]);
+        }
+        tolerance_ = tolerance;
+        maxLevel_ = maxLevel;
+        timeStepSize_ = timeStepSize;
+        context_ = *ctx;
+        for (int i=0; i<Ions::allComponents; i++) fixed_[i] = base->molalities[i];
+        base_ = *base;
+
+        nodes_.clear();
+        leafData_.clear();
+        samples_.clear();
+        numLeaves_ = 0;
+        corners_.clear();
+
+        // scale of each output (for the relative error) from the root corners
+        std::vector<int> lo(dimension_, 0), hi(dimension_, 1 << maxLevel_);
+        scale_.assign(numOutputs, 0.0);
+        for (int c=0; c < (1 << dimension_); c++){
+            const Scalar *out = &samples_[numOutputs*corner_(lo, hi, c)];
+            for (int k=0; k<numOutputs; k++)
+                if (std::isfinite(out[k])) scale_[k] = std::max(scale_[k], std::abs(out[k]));
+        }
+        for (int k=0; k<numOutputs; k++)
+            scale_[k] = std::max(1e-8 * scale_[k], std::numeric_limits<Scalar>::min());
+
+        nodes_.push_back(node_t());
+        refine_(0, lo, hi);
+        corners_.clear();
+        DBG("IonsTable: %d ions, %zu leaves, %zu samples\n", dimension_, numLeaves_, samples());
+    }
+
+    // interpolate(): table result for cm, false if the table does not apply.
+    bool interpolate(Scalar timeStepSize, chemicalModel_t *cm, const Context *ctx) const {
+        lookups_.fetch_add(1, std::memory_order_relaxed);
+        if (empty() || !matches_(timeStepSize, cm, ctx)) return false;
+
+        Scalar u[maxDimension];
+        const Scalar cells = 1 << maxLevel_;
+        for (int i=0; i<dimension_; i++){
+            Scalar m = cm->molalities[ions_[i]];
+            if (!(m > 0)) return false;
+            u[i] = (std::log10(m) - logLower_[i]) / (logUpper_[i] - logLower_[i]) * cells;
+            if (u[i] < 0 || u[i] > cells) return false;
+        }
+
+        int nodeIdx = 0;
+        while (nodes_[nodeIdx].splitDim >= 0) {
+            const node_t &node = nodes_[nodeIdx];
+            nodeIdx = node.child[(u[node.splitDim] >= node.mid)? 1 : 0];
+        }
+        const int *leaf = &leafData_[nodes_[nodeIdx].child[0]];
+        const int *lo = leaf;
+        const int *hi = leaf + dimension_;
+        const int *corner = leaf + 2*dimension_;
+
+        Scalar t[maxDimension];
+        weights_(u, lo, hi, t);
+
+        Scalar out[numOutputs];
+        for (int k=0; k<numOutputs; k++) out[k] = 0;
+        for (int c=0; c < (1 << dimension_); c++){
+            Scalar w = 1;
+            for (int i=0; i<dimension_; i++) w *= (c & (1 << i))? t[i] : 1 - t[i];
+            const Scalar *sample = &samples_[numOutputs*corner[c]];
+            if (!std::isfinite(sample[0])) return false; // corner did not converge
+            for (int k=0; k<numOutputs; k++) out[k] += w * sample[k];
+        }
+        *cm = base_;
+        unpack_(out, cm);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // write(): binary table file.
+    void write(const std::string &fileName) const {
+        FILE *file = fopen(fileName.c_str(), "wb");
+        if (!file) {
+            DUNE_THROW(Dune::IOError, "IonsTable: cannot write " << fileName);
+        }
+        header_t header = header_();
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(ions_.data(), sizeof(int), dimension_, file);
+        fwrite(logLower_.data(), sizeof(Scalar), dimension_, file);
+        fwrite(logUpper_.data(), sizeof(Scalar), dimension_, file);
+        fwrite(fixed_, sizeof(Scalar), Ions::allComponents, file);
+        fwrite(nodes_.data(), sizeof(node_t), nodes_.size(), file);
+        fwrite(leafData_.data(), sizeof(int), leafData_.size(), file);
+        fwrite(samples_.data(), sizeof(Scalar), samples_.size(), file);
+        bool failed = ferror(file);
+        fclose(file);
+        if (failed) {
+            DUNE_THROW(Dune::IOError, "IonsTable: error writing " << fileName);
+        }
+    }
+
+    // read(): table from write(), for a run with context ctx and the
+    //         molalities of base (those of the table ions are ignored).
+    //         The base chemical model is rebuilt from the fixed
+    //         molalities of the file.
+    void read(const std::string &fileName, const Context *ctx, const chemicalModel_t *base){
+        checkAvailable_();
+        FILE *file = fopen(fileName.c_str(), "rb");
+        if (!file) {
+            DUNE_THROW(Dune::IOError, "IonsTable: cannot read " << fileName);
+        }
+        header_t header;
+        bool ok = fread(&header, sizeof(header), 1, file) == 1;
+        header_t expected = header_();
+        ok = ok && !memcmp(header.magic, expected.magic, sizeof(header.magic))
+                && header.scalarSize == expected.scalarSize
+                && header.numIons == expected.numIons
+                && header.allComponents == expected.allComponents
+                && header.numOutputs == expected.numOutputs
+                && header.dimension >= 1 && header.dimension <= maxDimension
+                && header.maxLevel >= 1 && header.maxLevel <= 20
+                && header.numNodes >= 1 && header.numLeafData >= 0 && header.numSamples >= 0;
+        if (ok) {
+            dimension_ = header.dimension;
+            maxLevel_ = header.maxLevel;
+            tolerance_ = header.tolerance;
+            timeStepSize_ = header.timeStepSize;
+            context_ = Ions::makeContext(header.temperature);
+            context_.brineDensity = header.brineDensity;
+            for (int r=0; r<3; r++) context_.k1[r] = header.k1[r];
+            context_.network = header.network;
+            ions_.resize(dimension_);
+            logLower_.resize(dimension_);
+            logUpper_.resize(dimension_);
+            nodes_.resize(header.numNodes);
+            leafData_.resize(header.numLeafData);
+            samples_.resize(header.numSamples*numOutputs);
+            ok = fread(ions_.data(), sizeof(int), dimension_, file) == (std::size_t)dimension_
+              && fread(logLower_.data(), sizeof(Scalar), dimension_, file) == (std::size_t)dimension_
+              && fread(logUpper_.data(), sizeof(Scalar), dimension_, file) == (std::size_t)dimension_
+              && fread(fixed_, sizeof(Scalar), Ions::allComponents, file) == (std::size_t)Ions::allComponents
+              && fread(nodes_.data(), sizeof(node_t), nodes_.size(), file) == nodes_.size()
+              && fread(leafData_.data(), sizeof(int), leafData_.size(), file) == leafData_.size()
+              && fread(samples_.data(), sizeof(Scalar), samples_.size(), file) == samples_.size()
+              && consistent_();
+        }
+        fclose(file);
+        if (!ok) {
+            nodes_.clear();
+            DUNE_THROW(Dune::IOError, "IonsTable: " << fileName
+                       << " is not a table of this chemical model");
+        }
+        std::string mismatch = mismatch_(ctx, base);
+        if (!mismatch.empty()) {
+            nodes_.clear();
+            DUNE_THROW(Dune::InvalidStateException, "IonsTable: " << fileName
+                       << " was built for another run (" << mismatch
+                       << "), remove it or use another Chemistry.Table.File");
+        }
+        memset(&base_, 0, sizeof(base_));
+        for (int i=0; i<Ions::allComponents; i++) base_.molalities[i] = fixed_[i];
+        numLeaves_ = 0;
+        for (const auto &node : nodes_) if (node.splitDim < 0) numLeaves_++;
+        DBG("IonsTable: read %s: %d ions, %zu leaves, %zu samples\n",
+            fileName.c_str(), dimension_, numLeaves_, samples());
+    }
+
+private:
+    // node of the kd-tree: children split at integer coordinate mid
+    // of direction splitDim; a leaf (splitDim < 0) has its box and
+    // corner sample indices at leafData_[child[0]].
+    typedef struct node_t {
+        int splitDim;
+        int mid;
+        int child[2];
+    } node_t;
+
+    typedef struct header_t {
+        char magic[8];
+        int scalarSize;
+        int numIons;
+        int allComponents;
+        int numOutputs;
+        int dimension;
+        int maxLevel;
+        double tolerance;
+        double timeStepSize;
+        double temperature;
+        double brineDensity;
+        double k1[3];
+        int network;
+        long numNodes;
+        long numLeafData;
+        long numSamples;
+    } header_t;
+
+    header_t header_(void) const {
+        header_t header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "IONSTBL2", 8);
+        header.scalarSize = sizeof(Scalar);
+        header.numIons = Ions::numIons;
+        header.allComponents = Ions::allComponents;
+        header.numOutputs = numOutputs;
+        header.dimension = dimension_;
+        header.maxLevel = maxLevel_;
+        header.tolerance = tolerance_;
+        header.timeStepSize = timeStepSize_;
+        header.temperature = context_.temperature;
+        header.brineDensity = context_.brineDensity;
+        for (int r=0; r<3; r++) header.k1[r] = context_.k1[r];
+        header.network = context_.network;
+        header.numNodes = nodes_.size();
+        header.numLeafData = leafData_.size();
+        header.numSamples = samples();
+        return header;
+    }
+
+    static void checkAvailable_(void){
+#ifdef SOLVE_ODES
+        DUNE_THROW(Dune::InvalidStateException, "IonsTable: the speciation table is not available"
+                   " with SOLVE_ODES (the kinetics are integrated over each time step, a table"
+                   " would only apply to one step size); build without SOLVE_ODES or do not set"
+                   " Chemistry.Table.File");
+#endif
+    }
+
+    // consistent_(): ions, tree and corner indices of a table read from
+    //               a file are in range.
+    bool consistent_(void) const {
+        for (int i=0; i<dimension_; i++)
+            if (ions_[i] < Ions::numPhases || ions_[i] >= Ions::numComponents) return false;
+        const int numNodes = nodes_.size();
+        const int leafSize = 2*dimension_ + (1 << dimension_);
+        for (int nodeIdx=0; nodeIdx<numNodes; nodeIdx++){
+            const node_t &node = nodes_[nodeIdx];
+            if (node.splitDim >= 0) {
+                // children follow their parent (no cycles)
+                if (node.splitDim >= dimension_) return false;
+                for (int side=0; side<2; side++)
+                    if (node.child[side] <= nodeIdx || node.child[side] >= numNodes) return false;
+            }
+            else {
+                if (node.child[0] < 0 || (long)node.child[0] + leafSize > (long)leafData_.size()) return false;
+                const int *corner = &leafData_[node.child[0] + 2*dimension_];
+                for (int c=0; c < (1 << dimension_); c++)
+                    if (corner[c] < 0 || corner[c] >= (long)samples()) return false;
+            }
+        }
+        return true;
+    }
+
+    // mismatch_(): description of the differences between the context
+    //              and fixed molalities of the table and those of a
+    //              run, empty if the table applies to the run.
+    std::string mismatch_(const Context *ctx, const chemicalModel_t *base) const {
+        std::ostringstream mismatch;
+        auto add = [&mismatch](const std::string &what, Scalar table, Scalar run){
+            if (mismatch.tellp() > 0) mismatch << ", ";
+            mismatch << what << " " << table << " instead of " << run;
+        };
+        if (ctx->temperature != context_.temperature)
+            add("temperature", context_.temperature, ctx->temperature);
+        for (int r=0; r<3; r++)
+            if (ctx->k1[r] != context_.k1[r])
+                add(std::string("k1") + char('A'+r), context_.k1[r], ctx->k1[r]);
+        if (ctx->network != context_.network)
+            add("network", context_.network, ctx->network);
+        for (int compIdx=Ions::numPhases; compIdx<Ions::numComponents; compIdx++){
+            if (std::find(ions_.begin(), ions_.end(), compIdx) != ions_.end()) continue;
+            if (std::abs(base->molalities[compIdx] - fixed_[compIdx]) > tolerance_ * std::abs(fixed_[compIdx]))
+                add("molality of " + Ions::name(compIdx), fixed_[compIdx], base->molalities[compIdx]);
+        }
+        return mismatch.str();
+    }
+
+    // matches_(): same context and fixed molalities as the table.
+    bool matches_(Scalar timeStepSize, const chemicalModel_t *cm, const Context *ctx) const {
+        if (ctx->temperature != context_.temperature) return false;
+        for (int r=0; r<3; r++) if (ctx->k1[r] != context_.k1[r]) return false;
+        if (ctx->network != context_.network) return false;
+        for (int compIdx=Ions::numPhases; compIdx<Ions::numComponents; compIdx++){
+            bool variable = false;
+            for (int i=0; i<dimension_; i++) if (ions_[i] == compIdx) variable = true;
+            if (variable) continue;
+            if (std::abs(cm->molalities[compIdx] - fixed_[compIdx]) > tolerance_ * std::abs(fixed_[compIdx]))
+                return false;
+        }
+        return true;
+    }
+
+    static void pack_(const chemicalModel_t *cm, Scalar *out){
+        out[0] = cm->iS;
+        for (int i=0; i<Ions::allComponents; i++) out[1 + i] = cm->molalities[i];
+        for (int i=0; i<Ions::allComponents; i++) out[1 + Ions::allComponents + i] = cm->gamma[i];
+        for (int i=0; i<numRates; i++) out[1 + 2*Ions::allComponents + i] = cm->rateC[i];
+    }
+
+    static void unpack_(const Scalar *out, chemicalModel_t *cm){
+        cm->iS = out[0];
+        for (int i=0; i<Ions::allComponents; i++) cm->molalities[i] = out[1 + i];
+        for (int i=0; i<Ions::allComponents; i++) cm->gamma[i] = out[1 + Ions::allComponents + i];
+        for (int i=0; i<numRates; i++) cm->rateC[i] = out[1 + 2*Ions::allComponents + i];
+    }
+
+    // solve_(): solver result at integer coordinates (NaN if it failed).
+    void solve_(const Scalar *u, Scalar *out){
+        chemicalModel_t cm = base_;
+        for (int i=0; i<dimension_; i++) cm.molalities[ions_[i]] = molality_(i, u[i]);
+        Context ctx = context_;
+#ifndef SIMPLIFIED
+        speciationStatus_t status;
+        Ions::ionicStrength(timeStepSize_, &cm, &ctx, &status);
+        if (!status.converged) {
+            for (int k=0; k<numOutputs; k++) out[k] = std::numeric_limits<Scalar>::quiet_NaN();
+            return;
+        }
+#else
+        Ions::ionicStrength(timeStepSize_, &cm, &ctx);
+#endif
+        pack_(&cm, out);
+    }
+
+    // corner_(): sample index of corner c of box [lo, hi] (sampled once).
+    int corner_(const std::vector<int> &lo, const std::vector<int> &hi, int c){
+        std::vector<int> coords(dimension_);
+        for (int i=0; i<dimension_; i++) coords[i] = (c & (1 << i))? hi[i] : lo[i];
+        auto it = corners_.find(coords);
+        if (it != corners_.end()) return it->second;
+        int idx = samples();
+        samples_.resize(samples_.size() + numOutputs);
+        Scalar u[maxDimension];
+        for (int i=0; i<dimension_; i++) u[i] = coords[i];
+        solve_(u, &samples_[numOutputs*idx]);
+        corners_[coords] = idx;
+        return idx;
+    }
+
+    // refine_(): leaf for box [lo, hi] if the interpolation at its
+    //            center is good enough, otherwise split it.
+    void refine_(int nodeIdx, const std::vector<int> &lo, const std::vector<int> &hi){
+        const int numCorners = 1 << dimension_;
+        std::vector<int> corner(numCorners);
+        for (int c=0; c<numCorners; c++) corner[c] = corner_(lo, hi, c);
+
+        int splitDim = -1;
+        int width = 1;
+        for (int i=0; i<dimension_; i++)
+            if (hi[i] - lo[i] > width) { width = hi[i] - lo[i]; splitDim = i; }
+
+        if (splitDim >= 0 && error_(lo, hi, corner) > tolerance_) {
+            int mid = (lo[splitDim] + hi[splitDim]) / 2;
+            nodes_[nodeIdx].splitDim = splitDim;
+            nodes_[nodeIdx].mid = mid;
+            for (int side=0; side<2; side++){
+                int child = nodes_.size();
+                nodes_.push_back(node_t());
+                nodes_[nodeIdx].child[side] = child;
+                std::vector<int> childLo(lo), childHi(hi);
+                if (side) childLo[splitDim] = mid;
+                else childHi[splitDim] = mid;
+                refine_(child, childLo, childHi);
+            }
+            return;
+        }
+
+        nodes_[nodeIdx].splitDim = -1;
+        nodes_[nodeIdx].mid = 0;
+        nodes_[nodeIdx].child[0] = leafData_.size();
+        nodes_[nodeIdx].child[1] = -1;
+        leafData_.insert(leafData_.end(), lo.begin(), lo.end());
+        leafData_.insert(leafData_.end(), hi.begin(), hi.end());
+        leafData_.insert(leafData_.end(), corner.begin(), corner.end());
+        numLeaves_++;
+    }
+
+    // molality of direction i at (real) coordinate u
+    Scalar molality_(int i, Scalar u) const {
+        return std::pow(10.0, logLower_[i] + (logUpper_[i] - logLower_[i]) * u / (1 << maxLevel_));
+    }
+
+    // weights_(): interpolation weights t[i] of u in box [lo, hi],
+    //             linear in the molality.
+    void weights_(const Scalar *u, const int *lo, const int *hi, Scalar *t) const {
+        for (int i=0; i<dimension_; i++){
+            Scalar mLo = molality_(i, lo[i]);
+            Scalar mHi = molality_(i, hi[i]);
+            t[i] = (molality_(i, u[i]) - mLo) / (mHi - mLo);
+        }
+    }
+
+    // error_(): relative error of the interpolation at the box center.
+    Scalar error_(const std::vector<int> &lo, const std::vector<int> &hi, const std::vector<int> &corner){
+        Scalar u[maxDimension];
+        for (int i=0; i<dimension_; i++) u[i] = 0.5 * (lo[i] + hi[i]);
+        Scalar exact[numOutputs];
+        solve_(u, exact);
+        if (!std::isfinite(exact[0])) return std::numeric_limits<Scalar>::max();
+
+        Scalar t[maxDimension];
+        weights_(u, lo.data(), hi.data(), t);
+        std::vector<Scalar> w(corner.size());
+        for (std::size_t c=0; c<corner.size(); c++){
+            w[c] = 1;
+            for (int i=0; i<dimension_; i++) w[c] *= (c & (1 << i))? t[i] : 1 - t[i];
+        }
+
+        Scalar error = 0;
+        for (int k=0; k<numOutputs; k++){
+            Scalar interpolated = 0;
+            for (std::size_t c=0; c<corner.size(); c++) interpolated += w[c] * samples_[numOutputs*corner[c] + k];
+            // outputs which the solver leaves non finite are copied as they are
+            if (!std::isfinite(interpolated) || !std::isfinite(exact[k])) {
+                if (std::isfinite(interpolated) != std::isfinite(exact[k])) return std::numeric_limits<Scalar>::max();
+                continue;
+            }
+            error = std::max(error, std::abs(interpolated - exact[k]) / (std::abs(exact[k]) + scale_[k]));
+        }
+        return error;
+    }
+
+    int dimension_;
+    int maxLevel_;
+    Scalar tolerance_;
+    Scalar timeStepSize_;
+    Context context_;
+    chemicalModel_t base_;
+    Scalar fixed_[Ions::allComponents];
+    std::vector<int> ions_;
+    std::vector<Scalar> logLower_;
+    std::vector<Scalar> logUpper_;
+    std::vector<node_t> nodes_;
+    std::vector<int> leafData_;
+    std::vector<Scalar> samples_;
+    std::size_t numLeaves_;
+    // build only
+    std::vector<Scalar> scale_;
+    std::map<std::vector<int>, int> corners_;
+
+    mutable std::atomic<long> lookups_;
+    mutable std::atomic<long> hits_;
+};
+
+} // end namespace Dumux
+
+#endif
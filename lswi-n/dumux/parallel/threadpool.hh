@@ -0,0 +1,229 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+#ifndef DUMUX_THREAD_POOL_HH
+#define DUMUX_THREAD_POOL_HH
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+ * \file
+ * \ingroup Parallel
+ * \brief Work stealing thread pool for loops over independent items.
+ */
+namespace Dumux {
+
+/*!
+ * \ingroup Parallel
+ * \brief Thread pool with work stealing for parallel loops.
+ *
+ * parallelFor() splits the index range in one contiguous block per
+ * thread. Each thread takes chunks of grain items from the front of its
+ * own block; a thread whose block is empty steals the back half of the
+ * largest remaining block of another thread. Items of different cost
+ * (e.g. cells where the speciation needs more iterations) are so
+ * balanced without a shared queue.
+ *
+ * The calling thread works as thread 0, the pool holds the other
+ * numThreads-1 threads, which sleep between loops. The loop body gets
+ * the item index and the index of the thread running it, so that
+ * scratch data can be kept per thread. An exception thrown by the body
+ * is rethrown by parallelFor() once all threads have finished.
+ */
+class ThreadPool {
+public:
+    //! numThreads <= 0 uses the hardware concurrency
+    explicit ThreadPool(int numThreads = 0)
+    {
+        if (numThreads <= 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        blocks_.reset(new Block[numThreads]);
+        numThreads_ = numThreads;
+        for (int threadIdx = 1; threadIdx < numThreads_; threadIdx++)
+            threads_.emplace_back([this, threadIdx]{ run_(threadIdx); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : threads_) thread.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    //! number of threads working in a loop (including the calling thread)
+    int size(void) const { return numThreads_; }
+
+    /*!
+     * \brief Call f(i, threadIdx) for i in [0, n).
+     *
+     * \param grain number of items taken at once from a block
+     */
+    template<class F>
+    void parallelFor(std::size_t n, F&& f, std::size_t grain = 16)
+    {
+        if (n == 0) return;
+        grain_ = std::max<std::size_t>(grain, 1);
+        if (numThreads_ == 1 || n <= grain_) {
+            for (std::size_t i = 0; i < n; i++) f(i, 0);
+            return;
+        }
+
+        const std::size_t blockSize = (n + numThreads_ - 1)/numThreads_;
+        for (int threadIdx = 0; threadIdx < numThreads_; threadIdx++) {
+            blocks_[threadIdx].begin = std::min(n, threadIdx*blockSize);
+            blocks_[threadIdx].end = std::min(n, (threadIdx + 1)*blockSize);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            body_ = [&f](std::size_t i, int threadIdx){ f(i, threadIdx); };
+            error_ = nullptr;
+            running_ = numThreads_ - 1;
+            generation_++;
+        }
+        wake_.notify_all();
+
+        work_(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]{ return running_ == 0; });
+        body_ = nullptr;
+        if (error_) std::rethrow_exception(error_);
+    }
+
+private:
+    // Remaining items of one thread (padded against false sharing).
+    struct Block {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        char padding[64];
+    };
+
+    void run_(int threadIdx)
+    {
+        unsigned generation = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&]{ return stop_ || generation_ != generation; });
+                if (stop_) return;
+                generation = generation_;
+            }
+            work_(threadIdx);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                running_--;
+            }
+            done_.notify_one();
+        }
+    }
+
+    void work_(int threadIdx)
+    {
+        std::size_t begin, end;
+        try {
+            while (next_(threadIdx, begin, end))
+                for (std::size_t i = begin; i < end; i++) body_(i, threadIdx);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) error_ = std::current_exception();
+            // leave the remaining items
+            for (int victim = 0; victim < numThreads_; victim++) {
+                std::lock_guard<std::mutex> blockLock(blocks_[victim].mutex);
+                blocks_[victim].begin = blocks_[victim].end;
+            }
+        }
+    }
+
+    // next_(): next chunk for a thread, from its own block or stolen.
+    bool next_(int threadIdx, std::size_t& begin, std::size_t& end)
+    {
+        Block& own = blocks_[threadIdx];
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (own.begin < own.end) {
+                    begin = own.begin;
+                    end = std::min(own.end, own.begin + grain_);
+                    own.begin = end;
+                    return true;
+                }
+            }
+
+            // steal the back half of the largest block
+            int victim = -1;
+            std::size_t largest = 0;
+            for (int i = 1; i < numThreads_; i++) {
+                int candidate = (threadIdx + i) % numThreads_;
+                std::lock_guard<std::mutex> lock(blocks_[candidate].mutex);
+                std::size_t remaining = blocks_[candidate].end - blocks_[candidate].begin;
+                if (remaining > largest) {
+                    largest = remaining;
+                    victim = candidate;
+                }
+            }
+            if (victim < 0) return false;
+
+            std::size_t stolenBegin, stolenEnd;
+            {
+                std::lock_guard<std::mutex> lock(blocks_[victim].mutex);
+                Block& block = blocks_[victim];
+                if (block.begin >= block.end) continue; // taken meanwhile
+                stolenEnd = block.end;
+                stolenBegin = block.end - (block.end - block.begin + 1)/2;
+                block.end = stolenBegin;
+            }
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.begin = stolenBegin;
+            own.end = stolenEnd;
+        }
+    }
+
+    int numThreads_;
+    std::vector<std::thread> threads_;
+    std::unique_ptr<Block[]> blocks_;
+    std::size_t grain_ = 1;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::function<void(std::size_t, int)> body_;
+    std::exception_ptr error_;
+    unsigned generation_ = 0;
+    int running_ = 0;
+    bool stop_ = false;
+};
+
+} // end namespace Dumux
+#endif
@@ -0,0 +1,489 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+/*!
+ * \file
+ * \ingroup TwoPNCModel
+ * \brief Reaction chemistry of the brine, applied by operator splitting
+ *        after each transport step.
+ */
+#ifndef DUMUX_2PNC_IMMISCIBLE_CHEMISTRY_STEP_HH
+#define DUMUX_2PNC_IMMISCIBLE_CHEMISTRY_STEP_HH
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/timer.hh>
+
+#include <dumux/common/parameters.hh>
+#include <dumux/common/properties.hh>
+
+#include "dumux/parallel/threadpool.hh"
+#include "dumux/material/fluidsystems/ions.hh"
+#include "dumux/material/fluidsystems/ionscache.hh"
+#include "dumux/material/fluidsystems/ionstable.hh"
+
+namespace Dumux {
+
+/*!
+ * \ingroup TwoPNCModel
+ * \brief Chemistry step of the sequential (operator splitting) reactive
+ *        transport.
+ *
+ * After the transport step has been solved, the chemical model
+ * (Ions::ionicStrength()) runs for every degree of freedom on its own:
+ * the particle mole fractions are converted to molalities, the
+ * speciation and reaction rates are solved, and the change of the
+ * particles over the step, dt times the reaction rate, is applied to
+ * the solution vector. With SOLVE_ODES the chemical model integrates
+ * the kinetics over the step itself (Ions::solveODEs()), and the change
+ * of the kinetic species by the integration is applied instead (not the
+ * shifts of the speciation, e.g. of Cl- by electroneutrality). The cells are independent, so
+ * they are distributed over a work stealing thread pool; each thread
+ * works with its own copy of the Ions::Context.
+ *
+ * Instead of reacting after the transport step, rates() gives the
+ * reaction rates of the particles for source terms of the transport
+ * (see Chemistry.Coupling in lswi-n.cc).
+ *
+ * A particle takes part in the chemistry if Problem.Particle.n.Ion (by
+ * default Problem.Particle.n.Idx) is the name of a transported ion of
+ * the chemical model ("Ca++", "Cl-", ...). The molalities of ions which
+ * are not particles are constant, from Chemistry.Molalities (one value
+ * per transported ion of the model, default 0).
+ *
+ * Parameters:
+ *  - Chemistry.Threads: number of threads (default 0: hardware concurrency)
+ *  - Chemistry.Grain: cells taken at once by a thread (default 16)
+ *  - Chemistry.ScalingBenchmark: repetitions of the thread scaling check
+ *    at the initial solution (see lswisimulation.hh), default 0: none
+ *  - Chemistry.K1A, Chemistry.K1B, Chemistry.K1C: rate constants (default 0)
+ *  - Chemistry.Network: kinetic reactions of the chemical model, "CaCO3",
+ *    "CaCO3-CaSO4" or "CaCO3-CaSO4-MgCO3" (default the one of the build)
+ *  - Chemistry.CacheTolerance: relative tolerance of the molalities for
+ *    reusing a speciation result (IonsCache, solved at the center of the
+ *    tolerance bin), default 0: no cache
+ *  - Chemistry.CacheSize: maximum number of cached results (default 65536)
+ *  - Chemistry.Table.File: speciation table (IonsTable) interpolated
+ *    instead of solving, the solver (or cache) is used where the table
+ *    does not apply. Default empty: no table. If the file does not exist
+ *    the table is built at the first step and written, over
+ *    Chemistry.Table.Lower..Chemistry.Table.Upper (molalities) of the
+ *    ions Chemistry.Table.Ions (default the ions of the particles), with
+ *    Chemistry.Table.Tolerance (default 1e-3) and Chemistry.Table.MaxLevel
+ *    (default 8). An existing file built for other rate constants,
+ *    temperature, network or Chemistry.Molalities is refused. Not
+ *    available with SOLVE_ODES.
+ */
+template<class TypeTag>
+class ChemistryStep
+{
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using Problem = GetPropType<TypeTag, Properties::Problem>;
+    using SolutionVector = GetPropType<TypeTag, Properties::SolutionVector>;
+    using PrimaryVariables = GetPropType<TypeTag, Properties::PrimaryVariables>;
+    using FluidSystem = GetPropType<TypeTag, Properties::FluidSystem>;
+    using Ions = Dumux::Ions<Scalar>;
+    using Context = typename Ions::Context;
+
+    // first particle in the primary variables (as in the problem)
+    static constexpr int firstParticleIdx = FluidSystem::comp0Idx + 1;
+
+public:
+    //! statistics of the chemistry steps
+    struct Statistics {
+        int steps = 0;
+        int rateUpdates = 0;    // rates() calls (reactive source terms)
+        long cells = 0;
+        long iterations = 0;    // speciation iterations
+        long failed = 0;        // speciation did not converge, cell left unchanged
+        long corrected = 0;     // negative input concentrations corrected
+        long cacheHits = 0;
+        long cacheMisses = 0;
+        long tableHits = 0;
+        long tableLookups = 0;
+        long odeSubsteps = 0;   // kinetic integration (SOLVE_ODES)
+        long odeRejected = 0;
+        double wallTime = 0;
+    };
+
+    ChemistryStep(const Problem& problem, const std::string& paramGroup = "")
+    : pool_(getParamFromGroup<int>(paramGroup, "Chemistry.Threads", 0))
+    {
+        grain_ = getParamFromGroup<int>(paramGroup, "Chemistry.Grain", 16);
+
+        ctx_ = Ions::makeContext(problem.temperature());
+        Ions::setK1A(&ctx_, getParamFromGroup<Scalar>(paramGroup, "Chemistry.K1A", 0.0));
+        Ions::setK1B(&ctx_, getParamFromGroup<Scalar>(paramGroup, "Chemistry.K1B", 0.0));
+        Ions::setK1C(&ctx_, getParamFromGroup<Scalar>(paramGroup, "Chemistry.K1C", 0.0));
+        if (hasParamInGroup(paramGroup, "Chemistry.Network"))
+            Ions::setNetwork(&ctx_, getParamFromGroup<std::string>(paramGroup, "Chemistry.Network"));
+
+        molalities_.assign(Ions::numComponents, 0.0);
+        if (hasParamInGroup(paramGroup, "Chemistry.Molalities")) {
+            auto molalities = getParamFromGroup<std::vector<Scalar>>(paramGroup, "Chemistry.Molalities");
+            if (molalities.size() != static_cast<std::size_t>(Ions::numIons))
+                DUNE_THROW(Dune::InvalidStateException, "Chemistry.Molalities needs "
+                           << Ions::numIons << " values, got " << molalities.size());
+            std::copy(molalities.begin(), molalities.end(), molalities_.begin() + Ions::numPhases);
+        }
+
+        // ion of the chemical model for each particle (-1: not reacting)
+        ion_.assign(problem.numParticles(), -1);
+        for (int particle = 0; particle < problem.numParticles(); particle++) {
+            const std::string group = "Problem.Particle." + std::to_string(particle+1);
+            const auto ion = getParamFromGroup<std::string>(paramGroup, group + ".Ion",
+                                                            problem.particleIdx(particle));
+            for (int compIdx = Ions::numPhases; compIdx < Ions::numComponents; compIdx++)
+                if (Ions::name(compIdx) == ion) ion_[particle] = compIdx;
+            if (ion_[particle] >= 0) {
+                DBG("chemistry: particle-%d (%s) is ion %s\n", particle,
+                    problem.particleIdx(particle).c_str(), ion.c_str());
+            }
+        }
+        if (std::none_of(ion_.begin(), ion_.end(), [](int ion){ return ion >= 0; })) {
+            DBG("chemistry: no particle is an ion of the chemical model, particles do not react\n");
+        }
+
+        const auto cacheTolerance = getParamFromGroup<Scalar>(paramGroup, "Chemistry.CacheTolerance", 0.0);
+        if (cacheTolerance > 0) {
+            const auto cacheSize = getParamFromGroup<int>(paramGroup, "Chemistry.CacheSize", 1<<16);
+            cache_ = std::make_unique<IonsCache<Scalar>>(cacheTolerance, cacheSize);
+            DBG("chemistry: speciation cache, relative tolerance %le, %d results\n", cacheTolerance, cacheSize);
+        }
+
+        tableFile_ = getParamFromGroup<std::string>(paramGroup, "Chemistry.Table.File", "");
+        if (!tableFile_.empty()) {
+#ifdef SOLVE_ODES
+            DUNE_THROW(Dune::InvalidStateException, "Chemistry.Table.File: the speciation table"
+                       " is not available with SOLVE_ODES, the kinetics are integrated over each"
+                       " time step and a table would only apply to the step size it was built with");
+#endif
+            table_ = std::make_unique<IonsTable<Scalar>>();
+            if (FILE *file = fopen(tableFile_.c_str(), "rb")) {
+                fclose(file);
+                const chemicalModel_t base = baseModel_();
+                table_->read(tableFile_, &ctx_, &base);
+            }
+            else
+                paramGroup_ = paramGroup; // build at the first step
+        }
+
+        contexts_.resize(pool_.size());
+        threadStatistics_.resize(pool_.size());
+        DBG("chemistry: %d threads\n", pool_.size());
+    }
+
+    //! Brine density [kg/m3] of the episode (conversion of the rates).
+    void setBrineDensity(Scalar density){
+        Ions::setBrineDensity(&ctx_, density);
+    }
+
+    /*!
+     * \brief React all degrees of freedom over a step of size dt.
+     *
+     * x is the solution of the transport step; the grid variables have to
+     * be updated with the result.
+     */
+    void apply(SolutionVector& x, Scalar dt)
+    {
+        if (ctx_.brineDensity <= 0)
+            DUNE_THROW(Dune::InvalidStateException, "ChemistryStep: brine density not set");
+
+        if (table_ && table_->empty())
+            buildTable_(dt);
+
+        Dune::Timer timer;
+        beginLoop_();
+        pool_.parallelFor(x.size(), [&](std::size_t dofIdx, int threadIdx){
+            react_(x[dofIdx], dt, &contexts_[threadIdx], threadStatistics_[threadIdx]);
+        }, grain_);
+        endLoop_();
+        statistics_.steps++;
+        statistics_.wallTime += timer.elapsed();
+    }
+
+    /*!
+     * \brief Reaction rates of the particles at x, for the reactive source
+     *        terms of the transport (instead of apply()).
+     *
+     * particleRates[dofIdx][firstParticleIdx + particle] is the rate of the
+     * mole fraction of the particle in the brine [1/s], converted from the
+     * molal rate as the change of apply() (so that both couplings change
+     * the particles alike); the source of the mole balance is this rate
+     * times the molar density and the volume fraction of the brine. The
+     * kinetics are not integrated (the
+     * rates are those at x). With freezeActivities the gammas are those
+     * of the ionic strength of the last evaluation without it, and only
+     * the equilibrium and the rates are solved, so that the rates may be
+     * updated at every Newton iteration. Cells which fail keep their
+     * previous rates.
+     */
+    template<class Rates>
+    void rates(const SolutionVector& x, std::vector<Rates>& particleRates, bool freezeActivities = false)
+    {
+        if (ctx_.brineDensity <= 0)
+            DUNE_THROW(Dune::InvalidStateException, "ChemistryStep: brine density not set");
+
+        // negative time step: no ODE's (see Ions::solveODEs())
+        const Scalar dt = -1.0;
+        if (table_ && table_->empty())
+            buildTable_(dt);
+        if (particleRates.size() != x.size())
+            particleRates.assign(x.size(), Rates(0.0));
+        if (ionicStrength_.size() != x.size()) {
+            ionicStrength_.assign(x.size(), 0.0);
+            freezeActivities = false;
+        }
+
+        Dune::Timer timer;
+        beginLoop_();
+        pool_.parallelFor(x.size(), [&](std::size_t dofIdx, int threadIdx){
+            chemicalModel_t cm;
+            Scalar kgWater;
+            speciationStatus_t status;
+            const Scalar *frozenIS = (freezeActivities)? &ionicStrength_[dofIdx] : nullptr;
+            if (!speciate_(x[dofIdx], dt, frozenIS, &contexts_[threadIdx], threadStatistics_[threadIdx],
+                           cm, kgWater, status))
+                return;
+            for (int particle = 0; particle < numParticles_(); particle++)
+                if (ion_[particle] >= 0 && !std::isfinite(cm.rateC[ion_[particle]])) {
+                    threadStatistics_[threadIdx].failed++;
+                    return;
+                }
+            for (int particle = 0; particle < numParticles_(); particle++)
+                particleRates[dofIdx][firstParticleIdx + particle] = (ion_[particle] >= 0)?
+                    Ions::molalRate(&cm, &contexts_[threadIdx], ion_[particle]) * kgWater : 0.0;
+            if (!freezeActivities)
+                ionicStrength_[dofIdx] = cm.iS;
+        }, grain_);
+        endLoop_();
+        statistics_.rateUpdates++;
+        statistics_.wallTime += timer.elapsed();
+    }
+
+    /*!
+     * \brief Wall time of solving the chemistry of all cells of x
+     *        repetitions times with numThreads threads (thread scaling).
+     *
+     * x is not changed. The speciation is always solved, without the cache
+     * and the table, so that every repetition does the same work. The
+     * statistics are not changed either.
+     */
+    double timeSolve(const SolutionVector& x, Scalar dt, int numThreads, int repetitions)
+    {
+        if (ctx_.brineDensity <= 0)
+            DUNE_THROW(Dune::InvalidStateException, "ChemistryStep: brine density not set");
+
+        ThreadPool pool(numThreads);
+        std::vector<Context> contexts(pool.size(), ctx_);
+        std::vector<Statistics> statistics(pool.size());
+        SolutionVector y(x);
+        Dune::Timer timer;
+        for (int repetition = 0; repetition < repetitions; repetition++) {
+            y = x;
+            pool.parallelFor(y.size(), [&](std::size_t dofIdx, int threadIdx){
+                react_(y[dofIdx], dt, &contexts[threadIdx], statistics[threadIdx], true);
+            }, grain_);
+        }
+        return timer.elapsed();
+    }
+
+    const Statistics& statistics(void) const { return statistics_; }
+
+    int numThreads(void) const { return pool_.size(); }
+
+private:
+    int numParticles_(void) const { return ion_.size(); }
+
+    void beginLoop_(void)
+    {
+        for (int threadIdx = 0; threadIdx < pool_.size(); threadIdx++) {
+            contexts_[threadIdx] = ctx_;
+            threadStatistics_[threadIdx] = Statistics();
+        }
+    }
+
+    void endLoop_(void)
+    {
+        for (int threadIdx = 0; threadIdx < pool_.size(); threadIdx++) {
+            const auto& s = threadStatistics_[threadIdx];
+            statistics_.cells += s.cells;
+            statistics_.iterations += s.iterations;
+            statistics_.failed += s.failed;
+            statistics_.odeSubsteps += s.odeSubsteps;
+            statistics_.odeRejected += s.odeRejected;
+            statistics_.corrected += contexts_[threadIdx].warned;
+        }
+        if (cache_) {
+            statistics_.cacheHits = cache_->hits();
+            statistics_.cacheMisses = cache_->misses();
+        }
+        if (table_) {
+            statistics_.tableHits = table_->hits();
+            statistics_.tableLookups = table_->lookups();
+        }
+    }
+
+    // speciate_(): chemical model of a degree of freedom for a step dt,
+    //              interpolated or solved. With frozenIS, the gammas are
+    //              those of *frozenIS and the speciation does not iterate.
+    //              With solveOnly, the table and the cache are not used.
+    //              Returns false if the cell has to be left unchanged.
+    //              status gets the kinetic change (SOLVE_ODES), zero
+    //              for tabulated results.
+    bool speciate_(const PrimaryVariables& priVars, Scalar dt, const Scalar *frozenIS,
+                   Context *ctx, Statistics& statistics, chemicalModel_t& cm, Scalar& kgWater,
+                   speciationStatus_t& status, bool solveOnly = false) const
+    {
+        status = {true, 0, 0, 0.0, 0, 0};
+        statistics.cells++;
+        Scalar xWater = 1.0;
+        for (int particle = 0; particle < numParticles_(); particle++)
+            xWater -= priVars[firstParticleIdx + particle];
+        if (xWater <= 0) {
+            statistics.failed++;
+            return false;
+        }
+        // kg of water per mol of brine: m = x/kgWater
+        kgWater = xWater * Ions::molarMass(Ions::H2OIdx);
+
+        cm = chemicalModel_t();
+        for (int compIdx = Ions::numPhases; compIdx < Ions::numComponents; compIdx++)
+            cm.molalities[compIdx] = molalities_[compIdx];
+        for (int particle = 0; particle < numParticles_(); particle++)
+            if (ion_[particle] >= 0)
+                cm.molalities[ion_[particle]] = priVars[firstParticleIdx + particle] / kgWater;
+
+        if (frozenIS) {
+            // Newton iterates may be slightly negative
+            for (int particle = 0; particle < numParticles_(); particle++)
+                if (ion_[particle] >= 0)
+                    cm.molalities[ion_[particle]] = std::max(0.0, cm.molalities[ion_[particle]]);
+            cm.iS = *frozenIS;
+            Ions::ionicStrength(&cm, ctx);
+            return true;
+        }
+
+        const bool tabulated = !solveOnly && table_ && table_->interpolate(dt, &cm, ctx);
+#ifndef SIMPLIFIED
+        if (!tabulated) {
+            if (cache_ && !solveOnly) cache_->ionicStrength(dt, &cm, ctx, &status);
+            else Ions::ionicStrength(dt, &cm, ctx, &status);
+            statistics.iterations += status.iterations;
+            statistics.odeSubsteps += status.odeSubsteps;
+            statistics.odeRejected += status.odeRejected;
+            if (!status.converged) {
+                statistics.failed++;
+                return false;
+            }
+        }
+#else
+        if (!tabulated) {
+            if (cache_ && !solveOnly) cache_->ionicStrength(dt, &cm, ctx);
+            else Ions::ionicStrength(dt, &cm, ctx);
+        }
+#endif
+        return true;
+    }
+
+    void react_(PrimaryVariables& priVars, Scalar dt, Context *ctx, Statistics& statistics,
+                bool solveOnly = false) const
+    {
+        chemicalModel_t cm;
+        Scalar kgWater;
+        speciationStatus_t status;
+        if (!speciate_(priVars, dt, nullptr, ctx, statistics, cm, kgWater, status, solveOnly))
+            return;
+
+        for (int particle = 0; particle < numParticles_(); particle++) {
+            if (ion_[particle] < 0) continue;
+#ifdef SOLVE_ODES
+            // only the kinetic species change over the step
+            const int kineticIdx = Ions::kineticIndex_(ion_[particle]);
+            Scalar dm = (kineticIdx >= 0)? status.kineticChange[kineticIdx] : 0.0;
+#else
+            // molal rate [mol/kg/s] of the rateC returned in mol/m3/s
+            Scalar dm = Ions::molalRate(&cm, ctx, ion_[particle]) * dt;
+#endif
+            Scalar& moleFraction = priVars[firstParticleIdx + particle];
+            moleFraction = std::max(0.0, moleFraction + dm*kgWater);
+        }
+    }
+
+    // baseModel_(): chemical model with the constant molalities.
+    chemicalModel_t baseModel_(void) const
+    {
+        chemicalModel_t base = chemicalModel_t();
+        for (int compIdx = Ions::numPhases; compIdx < Ions::numComponents; compIdx++)
+            base.molalities[compIdx] = molalities_[compIdx];
+        return base;
+    }
+
+    // buildTable_(): sample the table with the context of the first step.
+    void buildTable_(Scalar dt)
+    {
+        std::vector<int> ions;
+        if (hasParamInGroup(paramGroup_, "Chemistry.Table.Ions")) {
+            for (const auto& name : getParamFromGroup<std::vector<std::string>>(paramGroup_, "Chemistry.Table.Ions")) {
+                int ion = -1;
+                for (int compIdx = Ions::numPhases; compIdx < Ions::numComponents; compIdx++)
+                    if (Ions::name(compIdx) == name) ion = compIdx;
+                if (ion < 0)
+                    DUNE_THROW(Dune::InvalidStateException, "Chemistry.Table.Ions: unknown ion " << name);
+                ions.push_back(ion);
+            }
+        }
+        else
+            for (int ion : ion_) if (ion >= 0) ions.push_back(ion);
+
+        const auto lower = getParamFromGroup<std::vector<Scalar>>(paramGroup_, "Chemistry.Table.Lower");
+        const auto upper = getParamFromGroup<std::vector<Scalar>>(paramGroup_, "Chemistry.Table.Upper");
+        const auto tolerance = getParamFromGroup<Scalar>(paramGroup_, "Chemistry.Table.Tolerance", 1e-3);
+        const auto maxLevel = getParamFromGroup<int>(paramGroup_, "Chemistry.Table.MaxLevel", 8);
+
+        const chemicalModel_t base = baseModel_();
+        Dune::Timer timer;
+        table_->build(&ctx_, dt, ions, lower, upper, &base, tolerance, maxLevel);
+        table_->write(tableFile_);
+        DBG("chemistry: table %s built in %lf s\n", tableFile_.c_str(), timer.elapsed());
+    }
+
+    ThreadPool pool_;
+    int grain_;
+    Context ctx_;
+    std::vector<Scalar> molalities_;
+    std::vector<int> ion_;
+    std::vector<Scalar> ionicStrength_; // per dof, for rates() with frozen activities
+    std::vector<Context> contexts_;
+    std::vector<Statistics> threadStatistics_;
+    std::unique_ptr<IonsCache<Scalar>> cache_;
+    std::unique_ptr<IonsTable<Scalar>> table_;
+    std::string tableFile_;
+    std::string paramGroup_;
+    Statistics statistics_;
+};
+
+} // end namespace Dumux
+
+#endif
@@ -0,0 +1,105 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+/*!
+ * \file
+ * \ingroup TwoPNCModel
+ * \brief Element-wise calculation of the residual for the two-phase
+ *        immiscible n-component model.
+ */
+#ifndef DUMUX_2PNC_IMMISCIBLE_LOCAL_RESIDUAL_HH
+#define DUMUX_2PNC_IMMISCIBLE_LOCAL_RESIDUAL_HH
+
+#include <dumux/common/properties.hh>
+#include <dumux/porousmediumflow/compositional/localresidual.hh>
+
+namespace Dumux {
+
+/*!
+ * \ingroup TwoPNCModel
+ * \brief Compositional local residual with an optional variable step
+ *        BDF2 storage term.
+ *
+ * The problem has to provide timeIntegrationHistory() returning a
+ * Bdf2History. As long as the history is not active (implicit Euler
+ * selected, first step, after an episode switch) the storage term is the
+ * implicit Euler one of the compositional local residual.
+ */
+template<class TypeTag>
+class TwoPNCImmiscibleLocalResidual : public CompositionalLocalResidual<TypeTag>
+{
+    using ParentType = CompositionalLocalResidual<TypeTag>;
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using Problem = GetPropType<TypeTag, Properties::Problem>;
+    using NumEqVector = GetPropType<TypeTag, Properties::NumEqVector>;
+    using FVElementGeometry = typename GetPropType<TypeTag, Properties::GridGeometry>::LocalView;
+    using SubControlVolume = typename FVElementGeometry::SubControlVolume;
+    using ElementVolumeVariables = typename GetPropType<TypeTag, Properties::GridVolumeVariables>::LocalView;
+    using GridView = GetPropType<TypeTag, Properties::GridView>;
+    using Element = typename GridView::template Codim<0>::Entity;
+
+public:
+    using ElementResidualVector = typename ParentType::ElementResidualVector;
+    using ParentType::ParentType;
+    using ParentType::evalStorage;
+
+    /*!
+     * \brief Add the storage term of a sub control volume to the residual.
+     */
+    void evalStorage(ElementResidualVector& residual,
+                     const Problem& problem,
+                     const Element& element,
+                     const FVElementGeometry& fvGeometry,
+                     const ElementVolumeVariables& prevElemVolVars,
+                     const ElementVolumeVariables& curElemVolVars,
+                     const SubControlVolume& scv) const
+    {
+        const auto& history = problem.timeIntegrationHistory();
+        if (!history.active())
+        {
+            ParentType::evalStorage(residual, problem, element, fvGeometry,
+                                    prevElemVolVars, curElemVolVars, scv);
+            return;
+        }
+
+        const auto& curVolVars = curElemVolVars[scv];
+        const auto& prevVolVars = prevElemVolVars[scv];
+
+        NumEqVector storage = this->computeStorage(problem, scv, curVolVars);
+        NumEqVector prevStorage = this->computeStorage(problem, scv, prevVolVars);
+        NumEqVector oldStorage = history.storage(scv.dofIndex());
+
+        const Scalar dt = this->timeLoop().timeStepSize();
+        const auto weights = history.weights(dt);
+
+        storage *= weights[0]*curVolVars.extrusionFactor();
+        prevStorage *= weights[1]*prevVolVars.extrusionFactor();
+        oldStorage *= weights[2];
+
+        storage -= prevStorage;
+        storage += oldStorage;
+        storage *= scv.volume();
+        storage /= dt;
+
+        residual[scv.localDofIndex()] += storage;
+    }
+};
+
+} // end namespace Dumux
+
+#endif
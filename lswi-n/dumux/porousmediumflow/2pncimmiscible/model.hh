@@ -30,7 +30,10 @@
 #include <dumux/porousmediumflow/2pnc/model.hh>
 #include <dumux/porousmediumflow/2p/saturationreconstruction.hh>
 
+#include "dumux/material/fluidstates/2pncimmiscible.hh"
+
 #include "volumevariables.hh"
+#include "localresidual.hh"
 #include "iofields.hh"
 #include "indices.hh"
 namespace Dumux {
@@ -113,6 +116,21 @@ struct PrimaryVariableSwitch<TypeTag, TTag::TwoPNCImmiscible> { using type = NoP
 template<class TypeTag>
 struct IOFields<TypeTag, TTag::TwoPNCImmiscible> { using type = TwoPNCImmiscibleIOFields; };
 
+//! The local residual (compositional, with optional BDF2 storage term)
+template<class TypeTag>
+struct LocalResidual<TypeTag, TTag::TwoPNCImmiscible> { using type = TwoPNCImmiscibleLocalResidual<TypeTag>; };
+
+//! The compact fluid state: single component oil, isothermal
+template<class TypeTag>
+struct FluidState<TypeTag, TTag::TwoPNCImmiscible>
+{
+private:
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    using FluidSystem = GetPropType<TypeTag, Properties::FluidSystem>;
+public:
+    using type = TwoPNCImmiscibleFluidState<Scalar, FluidSystem>;
+};
+
 //! Set the volume variables property
 template<class TypeTag>
 struct VolumeVariables<TypeTag, TTag::TwoPNCImmiscible>
@@ -0,0 +1,558 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+/*!
+ * \file
+ * \ingroup TwoPNCModel
+ * \brief Newton solver for the two-phase immiscible n-component model.
+ */
+#ifndef DUMUX_2PNC_IMMISCIBLE_NEWTON_SOLVER_HH
+#define DUMUX_2PNC_IMMISCIBLE_NEWTON_SOLVER_HH
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/timer.hh>
+
+#include <dumux/common/parameters.hh>
+#include <dumux/nonlinear/newtonsolver.hh>
+
+namespace Dumux {
+
+/*!
+ * \ingroup TwoPNCModel
+ * \brief Newton solver for the two-phase immiscible n-component model
+ *        with row and column scaling of the linearized system.
+ *
+ * The primary variables mix a pressure of order 1e7 Pa with particle
+ * mole fractions of order 1e-3 down to 1e-6. With Newton.EnableScaling
+ * the columns of the Jacobian are multiplied by a reference magnitude per
+ * primary variable and every row is equilibrated (or multiplied by a
+ * fixed factor per equation given in Newton.EquationScaling). The
+ * convergence check then uses the update relative to the reference
+ * magnitudes, so that small mole fractions are not considered converged
+ * just because they are small compared to one.
+ *
+ * The Newton update can be limited (Newton.MaxSaturationChange caps the
+ * saturation change per iteration, Newton.EnableMoleFractionDamping keeps
+ * the mole fractions non-negative) and optionally be followed by a
+ * backtracking line search on the residual norm (Newton.UseBacktracking).
+ * This mainly helps at episode switches, where the inlet salinity jumps
+ * and dt is reset to the episode's DtInitial.
+ *
+ * With Newton.GoalOriented the shift tolerance is relaxed from step to
+ * step according to the recovery objective, see adaptToleranceToGoal().
+ *
+ * Newton and linear solver iterations, assemblies and failed attempts are
+ * accumulated so they can be reported per time step, per episode and per
+ * run.
+ */
+template <class Assembler, class LinearSolver, class ModelTraits>
+class TwoPNCImmiscibleNewtonSolver : public NewtonSolver<Assembler, LinearSolver>
+{
+    using ParentType = NewtonSolver<Assembler, LinearSolver>;
+    using Scalar = typename Assembler::Scalar;
+    using SolutionVector = typename Assembler::ResidualType;
+    using PrimaryVariables = typename SolutionVector::block_type;
+    using Indices = typename ModelTraits::Indices;
+
+    static constexpr int numEq = PrimaryVariables::dimension;
+    static constexpr int pressureIdx = Indices::pressureIdx;
+    static constexpr int saturationIdx = Indices::saturationIdx;
+
+    //! Mole fractions of the brine particles are all other primary variables.
+    static constexpr bool isMoleFractionIdx(int pvIdx)
+    { return pvIdx != pressureIdx && pvIdx != saturationIdx; }
+
+public:
+    //! Counters accumulated by the solver
+    struct Statistics
+    {
+        int iterations = 0;          //!< Newton iterations, including failed attempts
+        int linearSolves = 0;        //!< linear systems solved
+        int assemblies = 0;          //!< Jacobian assemblies
+        int residualEvaluations = 0; //!< residual-only assemblies of the line search
+        int solves = 0;              //!< calls to the Newton loop, including retries
+        int failures = 0;            //!< Newton loops which did not converge
+        int chops = 0;               //!< iterations in which the update was limited
+        int backtracks = 0;          //!< line search step reductions
+        double assemblyTime = 0.0;   //!< wall time of the Jacobian assemblies [s]
+    };
+    TwoPNCImmiscibleNewtonSolver(std::shared_ptr<Assembler> assembler,
+                                 std::shared_ptr<LinearSolver> linearSolver,
+                                 const std::string& paramGroup = "")
+    : ParentType(assembler, linearSolver, Dune::MPIHelper::getCollectiveCommunication(), paramGroup)
+    , paramGroup_(paramGroup)
+    {
+        enableScaling_ = getParamFromGroup<bool>(paramGroup, "Newton.EnableScaling", false);
+        maxScaledShift_ = getParamFromGroup<Scalar>(paramGroup, "Newton.MaxScaledShift",
+                              getParamFromGroup<Scalar>(paramGroup, "Newton.MaxRelativeShift", 1e-8));
+        maxScaledResidual_ = getParamFromGroup<Scalar>(paramGroup, "Newton.MaxScaledResidual", -1.0);
+
+        pvScaling_ = 1.0;
+        const auto pvScaling = getParamFromGroup<std::vector<Scalar>>(paramGroup, "Newton.PrimaryVariableScaling",
+                                                                      std::vector<Scalar>{});
+        if (!pvScaling.empty())
+            setPrimaryVariableScaling_(pvScaling);
+
+        equationScaling_ = getParamFromGroup<std::vector<Scalar>>(paramGroup, "Newton.EquationScaling",
+                                                                  std::vector<Scalar>{});
+        if (!equationScaling_.empty() && equationScaling_.size() != numEq)
+            DUNE_THROW(Dune::InvalidStateException, "Newton.EquationScaling needs "
+                       << numEq << " entries, got " << equationScaling_.size());
+
+        maxSaturationChange_ = getParamFromGroup<Scalar>(paramGroup, "Newton.MaxSaturationChange", -1.0);
+        enableMoleFractionDamping_ = getParamFromGroup<bool>(paramGroup, "Newton.EnableMoleFractionDamping", false);
+        moleFractionDamping_ = getParamFromGroup<Scalar>(paramGroup, "Newton.MoleFractionDamping", 0.5);
+        useBacktracking_ = getParamFromGroup<bool>(paramGroup, "Newton.UseBacktracking", false);
+        minLambda_ = getParamFromGroup<Scalar>(paramGroup, "Newton.BacktrackingMinLambda", 0.125);
+        sufficientDecrease_ = getParamFromGroup<Scalar>(paramGroup, "Newton.BacktrackingSufficientDecrease", 1e-4);
+
+        goalOriented_ = getParamFromGroup<bool>(paramGroup, "Newton.GoalOriented", false);
+        goalRecoveryTolerance_ = getParamFromGroup<Scalar>(paramGroup, "Newton.GoalRecoveryTolerance", 1e-2);
+        goalSensitivity_ = getParamFromGroup<Scalar>(paramGroup, "Newton.GoalSensitivity", 3.0);
+        goalMaxRelaxation_ = getParamFromGroup<Scalar>(paramGroup, "Newton.GoalMaxRelaxation", 1e4);
+        goalApproachFraction_ = getParamFromGroup<Scalar>(paramGroup, "Newton.GoalApproachFraction", 0.1);
+        strictShift_ = getParamFromGroup<Scalar>(paramGroup, "Newton.MaxRelativeShift", 1e-8);
+        strictScaledShift_ = maxScaledShift_;
+        strictReduction_ = getParamFromGroup<Scalar>(paramGroup, "Newton.ResidualReduction", 1e-5);
+        relaxation_ = 1.0;
+
+        if (moleFractionDamping_ <= 0.0 || moleFractionDamping_ >= 1.0)
+            DUNE_THROW(Dune::InvalidStateException, "Newton.MoleFractionDamping must be in (0,1)");
+
+        resetStatistics();
+        scaledShift_ = 0.0;
+        scaledResidual_ = 0.0;
+        residualNorm_ = 0.0;
+        lastIterations_ = 0;
+    }
+
+    /*!
+     * \brief Set the reference magnitude of each primary variable.
+     *
+     * Values given in the input file (Newton.PrimaryVariableScaling)
+     * take precedence over the ones set from the problem.
+     */
+    void setPrimaryVariableScaling(const PrimaryVariables& reference)
+    {
+        if (hasParamInGroup(paramGroup_, "Newton.PrimaryVariableScaling"))
+            return;
+        setPrimaryVariableScaling_(std::vector<Scalar>(reference.begin(), reference.end()));
+    }
+
+    bool scalingEnabled() const
+    { return enableScaling_; }
+
+    bool goalOriented() const
+    { return goalOriented_; }
+
+    /*!
+     * \brief Relax the Newton tolerances of the next time step according
+     *        to the recovery objective (only with Newton.GoalOriented).
+     *
+     * A relative solution error eps changes the outflow by about
+     * GoalSensitivity*eps*rate per unit time (the relative permeabilities
+     * are powers of the saturation). The error is not removed by later
+     * steps, it is carried in the saturation field until the target time,
+     * so the error of a step changes the recovery by about
+     * GoalSensitivity*eps*rate*timeToTarget. Distributing
+     * GoalRecoveryTolerance [%] over the episode in proportion to dt gives
+     * the admissible
+     * eps = GoalRecoveryTolerance*dt/(episodeLength*GoalSensitivity*|rate|*timeToTarget).
+     * The relaxation is limited to GoalMaxRelaxation times the strict
+     * tolerance and is reduced linearly to one in the last
+     * GoalApproachFraction of the episode, so that the recovery at the
+     * episode target time is computed with the strict tolerance. Without
+     * a recovery rate (first step, no production) there is no estimate
+     * and the strict tolerance is used.
+     *
+     * \param timeToTarget time left until the end of the episode
+     * \param episodeLength length of the episode
+     * \param timeStepSize size of the next time step
+     * \param recoveryRate recovery rate of the last step [%/s]
+     */
+    void adaptToleranceToGoal(Scalar timeToTarget, Scalar episodeLength, Scalar timeStepSize, Scalar recoveryRate)
+    {
+        if (!goalOriented_)
+            return;
+
+        using std::abs; using std::min; using std::max;
+        Scalar relaxation = 1.0;
+        if (timeStepSize > 0)
+        {
+            const Scalar carried = max(timeToTarget, timeStepSize)/timeStepSize;
+            const Scalar errorPerTolerance = episodeLength*carried*goalSensitivity_*abs(recoveryRate)*strictShift_;
+            if (errorPerTolerance > 0)
+                relaxation = min(goalMaxRelaxation_, goalRecoveryTolerance_/errorPerTolerance);
+        }
+        relaxation = max(relaxation, Scalar(1.0));
+
+        if (episodeLength > 0 && goalApproachFraction_ > 0)
+        {
+            const Scalar weight = min(Scalar(1.0), max(Scalar(0.0), timeToTarget/(goalApproachFraction_*episodeLength)));
+            relaxation = 1.0 + weight*(relaxation - 1.0);
+        }
+
+        relaxation_ = relaxation;
+        this->setMaxRelativeShift(relaxation_*strictShift_);
+        this->setResidualReduction(relaxation_*strictReduction_);
+        maxScaledShift_ = relaxation_*strictScaledShift_;
+    }
+
+    //! Factor by which the tolerances are currently relaxed
+    Scalar toleranceRelaxation() const
+    { return relaxation_; }
+
+    /*!
+     * \brief Function called with the iterate at the beginning of every
+     *        Newton iteration, before the assembly (e.g. to update lagged
+     *        coupling terms such as the reaction sources).
+     */
+    void setIterationHook(std::function<void(const SolutionVector&)> hook)
+    { iterationHook_ = std::move(hook); }
+
+    void newtonBeginStep(const SolutionVector& uCurrentIter) override
+    {
+        ParentType::newtonBeginStep(uCurrentIter);
+        if (iterationHook_)
+            iterationHook_(uCurrentIter);
+    }
+
+    /*!
+     * \brief Called after the linear system has been assembled.
+     *        Applies the row and column scaling in place.
+     */
+    void assembleLinearSystem(const SolutionVector& uCurrentIter) override
+    {
+        Dune::Timer timer;
+        ParentType::assembleLinearSystem(uCurrentIter);
+        count_(&Statistics::assemblies);
+        const double assemblyTime = timer.elapsed();
+        runStatistics_.assemblyTime += assemblyTime;
+        episodeStatistics_.assemblyTime += assemblyTime;
+
+        // norm of the residual at the last iterate, the reference of the line search
+        using std::sqrt;
+        residualNorm_ = sqrt(this->comm().sum(this->assembler().residual().two_norm2()));
+
+        if (enableScaling_)
+            scaleLinearSystem_();
+    }
+
+    /*!
+     * \brief Update the current solution with the (unscaled and
+     *        possibly limited) delta.
+     */
+    void newtonUpdate(SolutionVector& uCurrentIter,
+                      const SolutionVector& uLastIter,
+                      const SolutionVector& deltaU) override
+    {
+        count_(&Statistics::linearSolves);
+
+        const bool limitUpdate = enableScaling_ || maxSaturationChange_ > 0.0
+                                 || enableMoleFractionDamping_ || useBacktracking_;
+        if (!limitUpdate)
+        {
+            ParentType::newtonUpdate(uCurrentIter, uLastIter, deltaU);
+            return;
+        }
+
+        SolutionVector update(deltaU);
+
+        // the linear solver returned the update in scaled variables
+        if (enableScaling_)
+            for (std::size_t dofIdx = 0; dofIdx < update.size(); ++dofIdx)
+                for (int pvIdx = 0; pvIdx < numEq; ++pvIdx)
+                    update[dofIdx][pvIdx] *= pvScaling_[pvIdx];
+
+        if (chopUpdate_(uLastIter, update))
+            count_(&Statistics::chops);
+
+        if (useBacktracking_)
+            backtrack_(uCurrentIter, uLastIter, update);
+
+        if (enableScaling_)
+        {
+            scaledShift_ = 0.0;
+            for (std::size_t dofIdx = 0; dofIdx < uLastIter.size(); ++dofIdx)
+            {
+                for (int pvIdx = 0; pvIdx < numEq; ++pvIdx)
+                {
+                    using std::abs; using std::max;
+                    const Scalar reference = max(pvScaling_[pvIdx], abs(uLastIter[dofIdx][pvIdx]));
+                    scaledShift_ = max(scaledShift_, abs(update[dofIdx][pvIdx])/reference);
+                }
+            }
+            scaledShift_ = this->comm().max(scaledShift_);
+        }
+
+        ParentType::newtonUpdate(uCurrentIter, uLastIter, update);
+    }
+
+    /*!
+     * \brief With scaling enabled, the solution is converged if the
+     *        update relative to the reference magnitudes (and, optionally,
+     *        the scaled residual) is below the tolerance.
+     */
+    bool newtonConverged() const override
+    {
+        if (!enableScaling_)
+            return ParentType::newtonConverged();
+
+        if (scaledShift_ > maxScaledShift_)
+            return false;
+
+        return maxScaledResidual_ < 0 || scaledResidual_ <= maxScaledResidual_;
+    }
+
+    void newtonEnd() override
+    {
+        ParentType::newtonEnd();
+        lastIterations_ = this->numSteps_;
+        runStatistics_.iterations += this->numSteps_;
+        episodeStatistics_.iterations += this->numSteps_;
+        count_(&Statistics::solves);
+    }
+
+    //! Called if the Newton loop did not converge, before dt is reduced.
+    void newtonFail(SolutionVector& u) override
+    {
+        ParentType::newtonFail(u);
+        count_(&Statistics::failures);
+    }
+
+    //! Reset the counters of the run and of the current episode.
+    void resetStatistics()
+    {
+        runStatistics_ = Statistics();
+        episodeStatistics_ = Statistics();
+    }
+
+    //! Start accumulating the counters of a new episode.
+    void resetEpisodeStatistics()
+    { episodeStatistics_ = Statistics(); }
+
+    //! Counters since the start of the run
+    const Statistics& runStatistics() const
+    { return runStatistics_; }
+
+    //! Counters since the last call to resetEpisodeStatistics()
+    const Statistics& episodeStatistics() const
+    { return episodeStatistics_; }
+
+    //! Newton iterations of the last call to solve()
+    int lastIterations() const
+    { return lastIterations_; }
+
+    //! Newton iterations since the start of the run, including failed attempts
+    int numIterations() const
+    { return runStatistics_.iterations; }
+
+    //! Linear solves since the start of the run
+    int numLinearSolves() const
+    { return runStatistics_.linearSolves; }
+
+    //! Jacobian assemblies since the start of the run
+    int numAssemblies() const
+    { return runStatistics_.assemblies; }
+
+    Scalar scaledShift() const
+    { return scaledShift_; }
+
+    Scalar scaledResidual() const
+    { return scaledResidual_; }
+
+private:
+    void count_(int Statistics::*counter, int n = 1)
+    {
+        runStatistics_.*counter += n;
+        episodeStatistics_.*counter += n;
+    }
+
+    // Limit the update in place. The saturation change of every dof is
+    // capped at maxSaturationChange_ and mole fractions which would become
+    // negative are reduced by the damping factor instead. Returns true if
+    // any entry was limited on any process.
+    bool chopUpdate_(const SolutionVector& uLastIter, SolutionVector& update) const
+    {
+        int limited = 0;
+        for (std::size_t dofIdx = 0; dofIdx < update.size(); ++dofIdx)
+        {
+            using std::abs;
+            // note that the new solution is uLastIter - update
+            if (maxSaturationChange_ > 0.0 && abs(update[dofIdx][saturationIdx]) > maxSaturationChange_)
+            {
+                update[dofIdx][saturationIdx] = (update[dofIdx][saturationIdx] > 0.0)?
+                    maxSaturationChange_ : -maxSaturationChange_;
+                limited = 1;
+            }
+
+            if (!enableMoleFractionDamping_)
+                continue;
+
+            for (int pvIdx = 0; pvIdx < numEq; ++pvIdx)
+            {
+                if (!isMoleFractionIdx(pvIdx))
+                    continue;
+                const Scalar x = uLastIter[dofIdx][pvIdx];
+                if (x - update[dofIdx][pvIdx] < 0.0)
+                {
+                    update[dofIdx][pvIdx] = (x > 0.0)? moleFractionDamping_*x : 0.0;
+                    limited = 1;
+                }
+            }
+        }
+        return this->comm().max(limited) > 0;
+    }
+
+    // Backtracking on the residual norm: halve the step until the
+    // Armijo condition ||r(u - lambda*du)|| <= (1 - c*lambda)*||r(u)||
+    // holds or lambda reaches minLambda_. The update is scaled by the
+    // accepted lambda.
+    void backtrack_(SolutionVector& uCurrentIter, const SolutionVector& uLastIter, SolutionVector& update)
+    {
+        Scalar lambda = 1.0;
+        while (true)
+        {
+            uCurrentIter = update;
+            uCurrentIter *= -lambda;
+            uCurrentIter += uLastIter;
+
+            this->assembler().updateGridVariables(uCurrentIter);
+            const Scalar norm = this->assembler().residualNorm(uCurrentIter);
+            count_(&Statistics::residualEvaluations);
+
+            if (norm <= (1.0 - sufficientDecrease_*lambda)*residualNorm_ || lambda <= minLambda_)
+                break;
+
+            lambda *= 0.5;
+            count_(&Statistics::backtracks);
+        }
+
+        if (lambda < 1.0)
+            update *= lambda;
+    }
+
+    void setPrimaryVariableScaling_(const std::vector<Scalar>& reference)
+    {
+        if (reference.size() != numEq)
+            DUNE_THROW(Dune::InvalidStateException, "Primary variable scaling needs "
+                       << numEq << " entries, got " << reference.size());
+
+        for (int pvIdx = 0; pvIdx < numEq; ++pvIdx)
+        {
+            using std::abs;
+            if (!(abs(reference[pvIdx]) > 0))
+                DUNE_THROW(Dune::InvalidStateException, "Reference magnitude of primary variable "
+                           << pvIdx << " must be non-zero");
+            pvScaling_[pvIdx] = abs(reference[pvIdx]);
+        }
+    }
+
+    // A <- R A C and b <- R b where C holds the reference magnitudes of the
+    // primary variables and R the inverse largest entry of every row
+    // (or the user given factor of the equation).
+    void scaleLinearSystem_()
+    {
+        auto& A = this->assembler().jacobian();
+        auto& b = this->assembler().residual();
+
+        scaledResidual_ = 0.0;
+        for (auto row = A.begin(); row != A.end(); ++row)
+        {
+            const auto dofIdx = row.index();
+
+            for (auto col = row->begin(); col != row->end(); ++col)
+                for (int eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                    for (int pvIdx = 0; pvIdx < numEq; ++pvIdx)
+                        (*col)[eqIdx][pvIdx] *= pvScaling_[pvIdx];
+
+            for (int eqIdx = 0; eqIdx < numEq; ++eqIdx)
+            {
+                Scalar rowScaling = 1.0;
+                if (!equationScaling_.empty())
+                    rowScaling = equationScaling_[eqIdx];
+                else
+                {
+                    Scalar rowMax = 0.0;
+                    for (auto col = row->begin(); col != row->end(); ++col)
+                        for (int pvIdx = 0; pvIdx < numEq; ++pvIdx)
+                        {
+                            using std::abs; using std::max;
+                            rowMax = max(rowMax, abs((*col)[eqIdx][pvIdx]));
+                        }
+                    if (rowMax > 0)
+                        rowScaling = 1.0/rowMax;
+                }
+
+                for (auto col = row->begin(); col != row->end(); ++col)
+                    for (int pvIdx = 0; pvIdx < numEq; ++pvIdx)
+                        (*col)[eqIdx][pvIdx] *= rowScaling;
+
+                b[dofIdx][eqIdx] *= rowScaling;
+
+                using std::abs; using std::max;
+                scaledResidual_ = max(scaledResidual_, abs(b[dofIdx][eqIdx]));
+            }
+        }
+        scaledResidual_ = this->comm().max(scaledResidual_);
+    }
+
+    std::string paramGroup_;
+    std::function<void(const SolutionVector&)> iterationHook_;
+    bool enableScaling_;
+    Scalar maxScaledShift_;
+    Scalar maxScaledResidual_;
+    PrimaryVariables pvScaling_;
+    std::vector<Scalar> equationScaling_;
+
+    Scalar maxSaturationChange_;
+    bool enableMoleFractionDamping_;
+    Scalar moleFractionDamping_;
+    bool useBacktracking_;
+    Scalar minLambda_;
+    Scalar sufficientDecrease_;
+
+    bool goalOriented_;
+    Scalar goalRecoveryTolerance_;
+    Scalar goalSensitivity_;
+    Scalar goalMaxRelaxation_;
+    Scalar goalApproachFraction_;
+    Scalar strictShift_;
+    Scalar strictScaledShift_;
+    Scalar strictReduction_;
+    Scalar relaxation_;
+
+    Scalar scaledShift_;
+    Scalar scaledResidual_;
+    Scalar residualNorm_;
+
+    int lastIterations_;
+    Statistics runStatistics_;
+    Statistics episodeStatistics_;
+};
+
+} // end namespace Dumux
+
+#endif
@@ -133,15 +133,13 @@ public:
         typename FluidSystem::ParameterCache paramCache;
         paramCache.updateAll(fluidState_);
 
-        using MaterialLaw = typename Problem::SpatialParams::MaterialLaw;
-        const auto& matParams = problem.spatialParams().materialLawParams(element, problem, scv, elemSol);
-
-        const int wPhaseIdx = problem.spatialParams().template wettingPhase<FluidSystem>(element, scv, elemSol);
+        const int wPhaseIdx = fluidState_.wettingPhase();
         const int nPhaseIdx = 1 - wPhaseIdx;
 
-        // mobilities -> require wetting phase saturation as parameter!
-        mobility_[wPhaseIdx] = MaterialLaw::krw(matParams, saturation(wPhaseIdx))/fluidState_.viscosity(wPhaseIdx);
-        mobility_[nPhaseIdx] = MaterialLaw::krn(matParams, saturation(wPhaseIdx))/fluidState_.viscosity(nPhaseIdx);
+        // mobilities, the relative permeabilities were evaluated
+        // together with the capillary pressure
+        mobility_[wPhaseIdx] = krw_/fluidState_.viscosity(wPhaseIdx);
+        mobility_[nPhaseIdx] = krn_/fluidState_.viscosity(nPhaseIdx);
 
         // binary diffusion coefficients
         diffCoefficient_.fill(0.0);
@@ -173,6 +171,8 @@ public:
      * \param fluidState The fluid state
      *
      * Set temperature, saturations, capillary pressures, viscosities, densities and enthalpies.
+     * The relative permeabilities are evaluated together with the capillary
+     * pressure, with one set-up of the material law parameters.
      */
     template<class ElemSol, class Problem, class Element, class Scv>
     void completeFluidState(const ElemSol& elemSol,
@@ -197,7 +197,7 @@ public:
             {
                 fluidState.setSaturation(phase1Idx, priVars[saturationIdx]);
                 fluidState.setSaturation(phase0Idx, 1 - priVars[saturationIdx]);
-                pc_ = MaterialLaw::pc(materialParams, fluidState.saturation(wPhaseIdx));
+                updateMaterialLaw_<MaterialLaw>(materialParams, fluidState.saturation(wPhaseIdx));
                 fluidState.setPressure(phase1Idx, priVars[pressureIdx] - pc_);
             }
             else
@@ -206,7 +206,7 @@ public:
                                                                                 scv, elemSol, priVars[saturationIdx]);
                 fluidState.setSaturation(phase1Idx, Sn);
                 fluidState.setSaturation(phase0Idx, 1 - Sn);
-                pc_ = MaterialLaw::pc(materialParams, fluidState.saturation(wPhaseIdx));
+                updateMaterialLaw_<MaterialLaw>(materialParams, fluidState.saturation(wPhaseIdx));
                 fluidState.setPressure(phase1Idx, priVars[pressureIdx] + pc_);
             }
         }
@@ -219,14 +219,14 @@ public:
                                                                                 scv, elemSol, priVars[saturationIdx]);
                 fluidState.setSaturation(phase0Idx, Sn);
                 fluidState.setSaturation(phase1Idx, 1 - Sn);
-                pc_ = MaterialLaw::pc(materialParams, fluidState.saturation(wPhaseIdx));
+                updateMaterialLaw_<MaterialLaw>(materialParams, fluidState.saturation(wPhaseIdx));
                 fluidState.setPressure(phase0Idx, priVars[pressureIdx] + pc_);
             }
             else
             {
                 fluidState.setSaturation(phase0Idx, priVars[saturationIdx]);
                 fluidState.setSaturation(phase1Idx, 1.0 - priVars[saturationIdx]);
-                pc_ = MaterialLaw::pc(materialParams, fluidState.saturation(wPhaseIdx));
+                updateMaterialLaw_<MaterialLaw>(materialParams, fluidState.saturation(wPhaseIdx));
                 fluidState.setPressure(phase0Idx, priVars[pressureIdx] - pc_);
             }
         }
@@ -255,6 +255,9 @@ public:
         fluidState.setMoleFraction(singlecomponentPhaseIdx, lastCompIdx, 1.0);
 
         paramCache.updateAll(fluidState);
+        // brine density and viscosity of the episode
+        paramCache.setMultiComponentPhase(problem.spatialParams().episodeBrineDensity(),
+                                          problem.spatialParams().episodeBrineViscosity());
         for (int phaseIdx = 0; phaseIdx < ModelTraits::numPhases(); ++phaseIdx)
         {
             Scalar rho = FluidSystem::density(fluidState, paramCache, phaseIdx);
@@ -417,6 +420,17 @@ protected:
     SolidState solidState_;
 
 private:
+    // pc, krw and krn at the wetting phase saturation sw, with the
+    // material law parameters of completeFluidState() (update() needs
+    // krw and krn for the mobilities)
+    template<class MaterialLaw, class MaterialLawParams>
+    void updateMaterialLaw_(const MaterialLawParams& params, Scalar sw)
+    {
+        pc_ = MaterialLaw::pc(params, sw);
+        krw_ = MaterialLaw::krw(params, sw);
+        krn_ = MaterialLaw::krn(params, sw);
+    }
+
     void setDiffusionCoefficient_(int phaseIdx, int compIdx, Scalar d)
     {
         if (compIdx < phaseIdx)
@@ -429,6 +443,8 @@ private:
     }
 
     Scalar pc_;                     //!< The capillary pressure
+    Scalar krw_;                    //!< Relative permeability of the wetting phase
+    Scalar krn_;                    //!< Relative permeability of the non-wetting phase
     Scalar porosity_;               //!< Effective porosity within the control volume
     PermeabilityType permeability_; //!> Effective permeability within the control volume
     Scalar mobility_[ModelTraits::numPhases()]; //!< Effective mobility within the control volume
@@ -88,10 +88,9 @@ public:
 
         //
         // Get heap memory for Cation/anion concentrations.
-        numParticles_ = getParam<int>("Problem.Particles");
-        if (numParticles_ != BRINE_N_COMPONENTS - 1){
-            DUNE_THROW(Dune::InvalidStateException, "Problem.Particles does not match (BRINE_N_COMPONENTS-1) : " << numParticles_ << " != " << BRINE_N_COMPONENTS-1);
-        }
+        // Particles of the type tag (water, particles and oil), selected
+        // from Problem.Particles by main().
+        numParticles_ = GetPropType<TypeTag, Properties::FluidSystem>::numComponents - 2;
 
         particles_ = (particle_t *)calloc(numParticles_, sizeof(particle_t));
         if (!particles_) this->callocError("(particle_t *)");
@@ -321,6 +320,15 @@ protected:
     Scalar xParticleInitial(int particleIdx) const {
         return xParticles_[0][particleIdx];
     }
+    // Largest mole fraction of a particle over the initial conditions
+    // and all stages (used as reference magnitude for scaling).
+    Scalar xParticleMax(int particleIdx) const {
+        Scalar max = 0;
+        for (int stage=0; stage<this->stages_+1; stage++){
+            if (xParticles_[stage][particleIdx] > max) max = xParticles_[stage][particleIdx];
+        }
+        return max;
+    }
     Scalar xParticleInitialTotal(void) const {
         Scalar total = 0;
         for (auto particle=0; particle<numParticles_; particle++){
@@ -24,6 +24,9 @@
 #ifndef LSWI_PROBLEM_HH
 #define LSWI_PROBLEM_HH
 
+#include <type_traits>
+#include <vector>
+
 #include <dune/grid/yaspgrid.hh>
 
 #include <dumux/discretization/elementsolution.hh>
@@ -40,6 +43,7 @@
 
 #include "dumux/material/fluidsystems/brine-n.hh"
 #include "dumux/material/components/oil.hh"
+#include "dumux/common/bdf2history.hh"
 
 namespace Dumux {
 
@@ -58,8 +62,20 @@ namespace Properties
 namespace TTag {
 struct LSWF2pncTypeTag { using InheritsFrom = std::tuple<TwoPNCImmiscible>; };
 struct LSWFBoxTypeTag { using InheritsFrom = std::tuple<LSWF2pncTypeTag, BoxModel>; };
+// the box model with a given number of particles in the brine
+template<int numParticles>
+struct LSWFBoxParticlesTypeTag { using InheritsFrom = std::tuple<LSWFBoxTypeTag>; };
 } // end namespace TTag
 
+// Number of particles (ions) in the brine. Problem.Particles of the input
+// file selects the type tag at startup.
+template<class TypeTag, class MyTypeTag>
+struct NumParticles { using type = UndefinedProperty; };
+
+template<class TypeTag, int numParticles>
+struct NumParticles<TypeTag, TTag::LSWFBoxParticlesTypeTag<numParticles>>
+{ static constexpr int value = numParticles; };
+
 // Set the grid type. We use a structured 2D grid.
 template<class TypeTag>
 struct Grid<TypeTag, TTag::LSWF2pncTypeTag> { using type = Dune::YaspGrid<2>; };
@@ -90,7 +106,8 @@ template <class TypeTag>
 struct FluidSystem<TypeTag, TTag::LSWF2pncTypeTag> {
     using type = FluidSystems::TwoPNCImmiscible<
         SCALAR_,  // First template argument
-        FluidSystems::Brine<SCALAR_>,  // second template argument: MultiComponentPhase
+        // second template argument: MultiComponentPhase
+        FluidSystems::Brine<SCALAR_, getPropValue<TypeTag, Properties::NumParticles>()>,
         // third template argument: SingleComponentPhase, this will in turn
         // have a template argument specifying the component
         FluidSystems::OnePLiquid<SCALAR_, Components::Oil<SCALAR_> > >;
@@ -100,6 +117,16 @@ struct FluidSystem<TypeTag, TTag::LSWF2pncTypeTag> {
 template<class TypeTag>
 struct UseMoles<TypeTag, TTag::LSWF2pncTypeTag> { static constexpr bool value = true; };
 
+#ifndef NO_GRID_CACHE
+// Cache the volume and flux variables of the whole grid. The volume
+// variables only depend on the solution and the episode, the caches
+// are rebuilt at each episode switch (see LSWF2pncProblem::setEpisode()).
+template<class TypeTag>
+struct EnableGridVolumeVariablesCache<TypeTag, TTag::LSWFBoxTypeTag> { static constexpr bool value = true; };
+template<class TypeTag>
+struct EnableGridFluxVariablesCache<TypeTag, TTag::LSWFBoxTypeTag> { static constexpr bool value = true; };
+#endif
+
 } // end namespace Properties
 
 template <class TypeTag>
@@ -108,6 +135,7 @@ class LSWF2pncProblem :
     ,protected LswiData<TypeTag>
 {
     using ParentType = PorousMediumFlowProblem<TypeTag>;
+    using SpatialParams = GetPropType<TypeTag, Properties::SpatialParams>;
 
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
     using Indices = typename GetPropType<TypeTag, Properties::ModelTraits>::Indices;
@@ -157,9 +185,38 @@ class LSWF2pncProblem :
     using GlobalPosition = Dune::FieldVector<Scalar, dimWorld>;
 
     enum { dofCodim = isBox ? dim : 0 };
-    mutable int currentEpisode_;
+    int currentEpisode_;
+
+    // Boundary faces of neumann(), classified by updateBoundaryFaces().
+    enum class BoundaryFace : char { noFlow, inlet, outlet };
+    struct BoundaryFaceData
+    {
+        BoundaryFace type;
+        int outletIdx; // index in outletFaces_ of outlet faces
+    };
+
+    // Shape function gradients at the integration point of an outlet
+    // face, the pressure gradient is the sum of p_i*gradN_i with the
+    // pressure of the vertices on the outlet fixed. The cell centered
+    // method has a single gradN, (ipGlobal - scvCenter)/distance^2.
+    struct OutletFace
+    {
+        std::vector<GlobalPosition> gradN;
+        std::vector<bool> fixedPressure;
+    };
 
 public:
+    using TimeIntegrationHistory = Bdf2History<Scalar, NumEqVector, SolutionVector>;
+
+    // Storage history for the BDF2 scheme (TimeLoop.Scheme), used by
+    // the local residual of the model.
+    const TimeIntegrationHistory& timeIntegrationHistory() const {
+        return timeIntegrationHistory_;
+    }
+    TimeIntegrationHistory& timeIntegrationHistory() {
+        return timeIntegrationHistory_;
+    }
+
     bool shouldWriteRestartFile() const
     {
         return true;
@@ -209,25 +266,62 @@ public:
     Scalar getTarget(int episodeIdx){ 
         return this->target(episodeIdx);
     }
+
+    // Interstitial speed of the salinity front injected in an episode
+    // (injection velocity over the porosity open to brine flow). Zero if
+    // the inlet salinity does not change at the start of the episode.
+    Scalar salinityFrontSpeed(int episodeIdx) {
+        Scalar previous = (episodeIdx > 0)?
+            this->xParticleTotal(episodeIdx-1) : this->xParticleInitialTotal();
+        if (this->xParticleTotal(episodeIdx) == previous) return 0;
+        Scalar mobilePorosity = this->MatrixPorosity(episodeIdx) *
+            (1.0 - this->get(episodeIdx, "MatrixSnr"));
+        return this->InjectionVelocity(episodeIdx) / mobilePorosity;
+    }
+
+    int numParticles(void) const {
+        return this->numParticles_;
+    }
+
+    // Identifier of a particle (Problem.Particle.n.Idx).
+    const std::string& particleIdx(int particle) const {
+        return this->particles_[particle].idx;
+    }
+
+    // Reference magnitudes of the primary variables for the scaling
+    // of the linear system (see TwoPNCImmiscibleNewtonSolver).
+    // Mole fractions which vanish in every stage fall back to 1e-6.
+    PrimaryVariables primaryVariableReference(void) const {
+        PrimaryVariables reference(1.0);
+        reference[pressureIdx] = this->InitialPressure();
+        reference[saturationIdx] = 1.0;
+        for (int particle=0; particle < this->numParticles_; particle++) {
+            int eqIdx = H2OIdx + particle + 1;
+            Scalar xMax = this->xParticleMax(particle);
+            reference[eqIdx] = (xMax > 0)? xMax : 1e-6;
+        }
+        return reference;
+    }
     
     /*!
      * \brief The constructor
      *
-     * \param timeManager The time manager
-     * \param gridView The grid view
+     * \param fvGridGeometry The finite volume grid geometry
      */
     LSWF2pncProblem(std::shared_ptr<const GridGeometry> fvGridGeometry)
     : ParentType(fvGridGeometry)
     {
         // Consider constant porosity throughout the run 
         // (no geomechanics).
-        static Scalar porosity = this->getValue("MatrixPorosity");
+        Scalar porosity = this->getValue("MatrixPorosity");
         // Consider the initial Swr for recovery calculation.
-        static Scalar Swr = this->getValue("MatrixSwr"); 
+        Scalar Swr = this->getValue("MatrixSwr"); 
         // Consider initial density and viscosity as well.
         // (hmmm...)
-        static Scalar brineDensity = this->getValue("BrineDensity");
-        static Scalar brineViscosity = this->getValue("BrineViscosity");
+        Scalar brineDensity = this->getValue("BrineDensity");
+        Scalar brineViscosity = this->getValue("BrineViscosity");
+        // Input file temperature is in Celcius, so we change to SI (K).
+        temperature_ = this->getValue("Temperature") + 273.15;
 
         if (!useMoles){
             DBG("!useMoles is deprecated\n");
@@ -236,6 +330,7 @@ public:
         // initial brine densities and viscosities           
         recovery_ = "gnuplot.dat";
         currentEpisode_ = 0;
+        updateBoundaryFaces();
 
         // Total area of all top scvf.area() in two dimensions
         simulationArea_ = this->upperRight_[0] * 1.0; 
@@ -248,7 +343,8 @@ public:
         // initial brine densities and viscosities           
         //initialize Brine fluid system
             DBG("initialize Brine fluid system\n");
-        FluidSystems::Brine<GetPropType<TypeTag, Properties::Scalar>>::init(brineDensity, brineViscosity,this->particles_);
+        FluidSystems::Brine<Scalar, numComponents-2>::init(this->particles_);
+        this->spatialParams().setEpisodeBrine(brineDensity, brineViscosity);
 
         // write caption into output file
             DBG("write caption into output file\n");
@@ -279,26 +375,68 @@ public:
      * This problem assumes a temperature of 90 degrees Celsius.
      */
     Scalar temperature() const {
-        // Input file temperature is in Celcius, so we change to SI (K).
         // Episode defined value not available.
-        static Scalar initialT = this->getValue("Temperature") + 273.15;
-        return initialT; 
+        return temperature_; 
     } 
 
 
     //! \copydoc Dumux::FVProblem::source()
+    // Reactive source of the particles: the cached reaction rates of
+    // the dof (change of the brine mole fractions per s, see
+    // ChemistryStep::rates()) times the brine molar density and volume
+    // fraction. The rates are updated by the chemistry only between
+    // Newton iterations (or time steps), not for the perturbed residuals
+    // of the numeric differentiation.
     NumEqVector source(const Element& element,
                    const ElementGeometry& fvGeometry,
                    const ElementVolumeVariables& elemVolVars,
                    const SubControlVolume& scv) const
-    { return NumEqVector(0.0); }
+    {
+        if (reactionRates_.empty())
+            return NumEqVector(0.0);
+        const auto& volVars = elemVolVars[scv];
+        NumEqVector source(reactionRates_[scv.dofIndex()]);
+        source *= volVars.porosity() * volVars.saturation(BrinePhaseIdx) * volVars.molarDensity(BrinePhaseIdx);
+        return source;
+    }
+
+    // Reaction rates per dof for source(), indexed by equation (empty:
+    // no reactive source). Set by the chemistry (Chemistry.Coupling).
+    std::vector<NumEqVector>& reactionRates() { return reactionRates_; }
     
+    // Set all episode dependent parameters of the volume variables:
+    // material law parameters, permeability, brine density and viscosity
+    // of the spatial params. Volume variables
+    // computed before (grid caches, previous time level) are out of date
+    // and must be updated by the caller, e.g. GridVariables::init().
+    void setEpisode(int episodeIdx){
+        this->spatialParams().setEpisode(episodeIdx);
+        setDensityViscosity(episodeIdx);
+    }
+
+    //! The episode dependent state of the parameters, see setEpisodeState()
+    struct EpisodeState {
+        typename SpatialParams::EpisodeState spatialParams;
+    };
+
+    EpisodeState episodeState() const
+    {
+        return {this->spatialParams().episodeState()};
+    }
+
+    // Go back to the parameters of an earlier state (setEpisode() enters
+    // the episodes in order only). The volume variables are out of date
+    // as with setEpisode().
+    void setEpisodeState(const EpisodeState& state){
+        this->spatialParams().setEpisodeState(state.spatialParams);
+    }
+
     void setDensityViscosity(int episodeIdx){
         // set constant densities and viscosities (called from timeloop)
-        FluidSystems::episodeDensity_ = this->injectionDensity(episodeIdx);
-        FluidSystems::episodeViscosity_ = this->injectionViscosity(episodeIdx);
-//        FluidSystems::episodeViscosity_ = this->brineViscosity_[episodeIdx];
-        DBG("Problem now setting episode %d density=%le viscosity=%le\n", episodeIdx, FluidSystems::episodeDensity_, FluidSystems::episodeViscosity_);
+        this->spatialParams().setEpisodeBrine(this->injectionDensity(episodeIdx),
+                                              this->injectionViscosity(episodeIdx));
+        DBG("Problem now setting episode %d density=%le viscosity=%le\n", episodeIdx,
+            this->spatialParams().episodeBrineDensity(), this->spatialParams().episodeBrineViscosity());
     }
 
       const Scalar injectionDensity(int epIdx){ 
@@ -352,16 +490,16 @@ public:
       const Scalar dirichletPressure = this->InitialPressure();
  
       PrimaryVariables flux(0.0);
-      const auto& ipGlobal = scvf.ipGlobal();
       const auto& volVars = elemVolVars[scvf.insideScvIdx()];
+      const auto& face = boundaryFaces_[boundaryFaceIndex_(element, scvf)];
 
       // no-flow everywhere except at the Outlet/Inlet)
-      if(ipGlobal[1] < this->fvGridGeometry().bBoxMax()[1] - eps_ && ipGlobal[1] > this->fvGridGeometry().bBoxMin()[1] + eps_)
+      if (face.type == BoundaryFace::noFlow)
       {
           return flux;
       }
 
-      if ( ipGlobal[1] < this->fvGridGeometry().bBoxMin()[1] + eps_)
+      if (face.type == BoundaryFace::inlet)
       {
           // calculate the flux
 
@@ -369,38 +507,7 @@ public:
           Scalar brinetpfaFlux = brinedensity * this->InjectionVelocity(currentEpisode_);
 
           // ///////////////   influx  ///////////////
-          int epIdx;
-          for (epIdx=0; epIdx < this->episodes_; epIdx++){
-              TRACE( "test: %le <= %le < %le\n", 
-                      this->lowerTimeStepBoundary(epIdx),this->time_ ,
-                      this->upperTimeStepBoundary(epIdx));
-            if (this->time_ >= this->lowerTimeStepBoundary(epIdx)
-                    &&
-                    this->time_ < this->upperTimeStepBoundary(epIdx)
-                 )
-            {
-                TRACE("episode %d\n", epIdx);
-                break;
-            }
-          }
-          
-
-          if (currentEpisode_ != epIdx) {
-              DBG("Problem now setting episode %d density=%le viscosity=%le\n", epIdx, FluidSystems::episodeDensity_, FluidSystems::episodeViscosity_);
-
-              DBG("*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*\n"); 
-              DBG("influx brine molar density = %lf brine mass density = %lf injection velocity[%d] = %le\n", 
-                volVars.molarDensity(BrinePhaseIdx), volVars.density(BrinePhaseIdx),
-                epIdx, this->InjectionVelocity(epIdx));
-              for (int i=0; i<numComponents-2; i++) {
-                  DBG("influx Boundary condition switch switch at %lf s., episode=%d --> %d: particle-%d flux= %le -->%le,\n", 
-                      time_, currentEpisode_, epIdx, i,
-                      -brinetpfaFlux *this->xParticle(i, currentEpisode_), 
-                      -brinetpfaFlux *this->xParticle(i, epIdx));
-                  }
-              DBG("*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*\n"); 
-              currentEpisode_ = epIdx;
-          }
+          // (episode of the current time, see setTime())
           Scalar moleFracSum = 0;
           for (int i=0; i<numComponents-2; i++){
               Scalar moleFrac = this->xParticle(i, currentEpisode_);
@@ -413,41 +520,25 @@ public:
           return flux;
       }
 
-      // construct the element solution
-      const auto elemSol = [&]()
+      // evaluate the gradient, the pressure of the outlet vertices
+      // (box) or of the outlet (cell centered) is fixed
+      const auto& outlet = outletFaces_[face.outletIdx];
+      GlobalPosition gradient(0.0);
+      if(isBox)
       {
-          auto sol = elementSolution(element, elemVolVars, fvGeometry);
-
-          if(isBox)
+          for (const auto& scv : scvs(fvGeometry))
           {
-              for(auto&& scvf : scvfs(fvGeometry))
-                  if(scvf.center()[1] > this->fvGridGeometry().bBoxMax()[1] - eps_)
-                  {
-                      sol[fvGeometry.scv(scvf.insideScvIdx()).indexInElement()][pressureIdx] = dirichletPressure;
-                  }
+              const int i = scv.indexInElement();
+              const Scalar pressure = outlet.fixedPressure[i] ?
+                  dirichletPressure : elemVolVars[scv].priVars()[pressureIdx];
+              gradient.axpy(pressure, outlet.gradN[i]);
           }
-          return sol;
-      }();
-
-      // evaluate the gradient
-      const auto gradient = [&]()->GlobalPosition
+      }
+      else
       {
-          if(isBox)
-          {
-              const auto grads = evalGradients(element, element.geometry(), fvGeometry.fvGridGeometry(), elemSol, ipGlobal);
-              return grads[pressureIdx];
-          }
-
-          else
-          {
-              const auto& scvCenter = fvGeometry.scv(scvf.insideScvIdx()).center();
-              const Scalar scvCenterPresureSol = elemSol[0][pressureIdx];
-              auto grad = ipGlobal - scvCenter;
-              grad /= grad.two_norm2();
-              grad *= (dirichletPressure - scvCenterPresureSol);
-              return grad;
-          }
-      }();
+          gradient = outlet.gradN[0];
+          gradient *= (dirichletPressure - volVars.priVars()[pressureIdx]);
+      }
 
       const Scalar K = volVars.permeability();
 
@@ -480,10 +571,15 @@ public:
       return flux;
     }
 
+    /*!
+     * \brief The oil volume flowing out of the outlet per time \f$\mathrm{[m^3/s]}\f$
+     *
+     * \param gridVolVars The grid volume variables of the solution
+     * \param x The solution
+     */
     template<class GridVolumeVariables, class SolutionVector>
-    void oilRecOutput(const GridVolumeVariables& gridVolVars, const SolutionVector& x, int episodeIdx) const
+    Scalar oilOutflux(const GridVolumeVariables& gridVolVars, const SolutionVector& x) const
     {
-        static Scalar total = 0.0;
         Scalar outflux = 0.0;
         for (const auto& element : elements(this->fvGridGeometry().gridView()))
         {
@@ -493,22 +589,52 @@ public:
             fvGeometry.bind(element);
             elemVolVars.bind(element, fvGeometry, x);
 
-            for (const auto& scvf : scvfs(fvGeometry))
-            {
-                const auto& ipGlobal = scvf.ipGlobal();
-                const auto& volVars = elemVolVars[scvf.insideScvIdx()];
-                const Scalar oildensity = useMoles ? volVars.molarDensity(OilPhaseIdx) : volVars.density(OilPhaseIdx);
-                if (ipGlobal[1] > this->fvGridGeometry().bBoxMax()[1] - eps_){
-                    outflux += neumann(element, fvGeometry, elemVolVars, scvf)[contiOilEqIdx]*scvf.area()/oildensity;
+            outflux += elementOilOutflux(element, fvGeometry, elemVolVars);
+        }
+        return outflux;
+    }
+
+    //! The part of oilOutflux() through the outlet faces of an element.
+    Scalar elementOilOutflux(const Element& element,
+                             const ElementGeometry& fvGeometry,
+                             const ElementVolumeVariables& elemVolVars) const
+    {
+        Scalar outflux = 0.0;
+        for (const auto& scvf : scvfs(fvGeometry))
+        {
+            const auto& volVars = elemVolVars[scvf.insideScvIdx()];
+            const Scalar oildensity = useMoles ? volVars.molarDensity(OilPhaseIdx) : volVars.density(OilPhaseIdx);
+            if (boundaryFaces_[boundaryFaceIndex_(element, scvf)].type == BoundaryFace::outlet){
+                outflux += neumann(element, fvGeometry, elemVolVars, scvf)[contiOilEqIdx]*scvf.area()/oildensity;
   
 
-                    TRACE("    neumann(element, fvGeometry, elemVolVars, scvf)[contiOilEqIdx]=%le\n",neumann(element, fvGeometry, elemVolVars, scvf)[contiOilEqIdx]); 
+                TRACE("    neumann(element, fvGeometry, elemVolVars, scvf)[contiOilEqIdx]=%le\n",neumann(element, fvGeometry, elemVolVars, scvf)[contiOilEqIdx]); 
 
-                    // [neumann] = mol/s/m2 (gradient * scvf.unitOuterNormal() *  density * mobility)
-                    // [neumann] / [oildensity] = (mol / s / m2) / (mol / m3) = m / s;    
-                }
+                // [neumann] = mol/s/m2 (gradient * scvf.unitOuterNormal() *  density * mobility)
+                // [neumann] / [oildensity] = (mol / s / m2) / (mol / m3) = m / s;    
             }
         }
+        return outflux;
+    }
+
+    //! The element has a face on the outlet.
+    bool hasOutletFace(const Element& element, const ElementGeometry& fvGeometry) const
+    {
+        for (const auto& scvf : scvfs(fvGeometry))
+            if (boundaryFaces_[boundaryFaceIndex_(element, scvf)].type == BoundaryFace::outlet)
+                return true;
+        return false;
+    }
+
+    //! The oil volume in place at the start \f$\mathrm{[m^3]}\f$, the recovery is relative to it.
+    Scalar initialOilVolume() const
+    { return oilVolume_; }
+
+    template<class GridVolumeVariables, class SolutionVector>
+    void oilRecOutput(const GridVolumeVariables& gridVolVars, const SolutionVector& x, int episodeIdx) const
+    {
+        Scalar& total = totalRecovery_;
+        Scalar outflux = oilOutflux(gridVolVars, x);
 
         auto initialOil = oilVolume_; // saturacion*w*h*porosidad*1
 
@@ -526,7 +652,7 @@ public:
         Scalar VPIi = injectionVolumeRate * step_;
 
 
-        static Scalar VPIt = 0;
+        Scalar& VPIt = injectedVolume_;
         VPIt += VPIi;
 
         Scalar VP = effectiveVolume_;
@@ -556,11 +682,66 @@ public:
     }
     
 
+    // Also sets the episode of the inlet boundary condition.
     void setTime(int i, Scalar t, Scalar s)
     {
         stepIndex_ = i-1;
         time_ = t;
         step_ = s;
+        updateInletEpisode_();
+    }
+
+    /*!
+     * \brief Classify the boundary faces as inlet, outlet or no-flow
+     *        and compute the shape function gradients of the outlet
+     *        faces used by neumann().
+     *
+     * Called by the constructor, call again if the grid geometry
+     * is updated.
+     */
+    void updateBoundaryFaces()
+    {
+        const auto& gridGeometry = this->fvGridGeometry();
+        auto fvGeometry = localView(gridGeometry);
+
+        // the box scvf indices are local to the element
+        if (isBox)
+        {
+            scvfOffset_.assign(gridGeometry.gridView().size(0) + 1, 0);
+            for (const auto& element : elements(gridGeometry.gridView()))
+            {
+                fvGeometry.bind(element);
+                scvfOffset_[gridGeometry.elementMapper().index(element) + 1] = fvGeometry.numScvf();
+            }
+            for (std::size_t eIdx = 1; eIdx < scvfOffset_.size(); eIdx++)
+                scvfOffset_[eIdx] += scvfOffset_[eIdx-1];
+            boundaryFaces_.resize(scvfOffset_.back());
+        }
+        else
+            boundaryFaces_.resize(gridGeometry.numScvf());
+        outletFaces_.clear();
+
+        for (const auto& element : elements(gridGeometry.gridView()))
+        {
+            fvGeometry.bind(element);
+            for (const auto& scvf : scvfs(fvGeometry))
+            {
+                const auto& ipGlobal = scvf.ipGlobal();
+                auto& face = boundaryFaces_[boundaryFaceIndex_(element, scvf)];
+                face.outletIdx = -1;
+                if (ipGlobal[1] < gridGeometry.bBoxMin()[1] + eps_)
+                    face.type = BoundaryFace::inlet;
+                else if (ipGlobal[1] > gridGeometry.bBoxMax()[1] - eps_)
+                {
+                    face.type = BoundaryFace::outlet;
+                    face.outletIdx = outletFaces_.size();
+                    outletFaces_.push_back(makeOutletFace_(element, fvGeometry, scvf,
+                                                           std::integral_constant<bool, isBox>()));
+                }
+                else
+                    face.type = BoundaryFace::noFlow;
+            }
+        }
     }
 
     /*!
@@ -591,9 +772,10 @@ public:
     }
     
     void recoveryOutput(int stepIndex, Scalar now, Scalar stepSize, Scalar averageVelocity, Scalar stepRecovery, Scalar totalRecovery, int episodeIdx) const {
-        static Scalar IPV = 0;
+        Scalar& IPV = injectedPoreVolumes_;
 
-        static time_t start = time(NULL); 
+        if (firstRecoveryOutput_) recoveryStart_ = time(NULL);
+        const time_t start = recoveryStart_;
         // Pore volume is the effectiveVolume_ (volume*porosity);
         //Scalar area =  cylinderArea_;
         //Scalar poreVolume =  cylinderOpenVolume_;
@@ -604,11 +786,10 @@ public:
         Scalar stepIPV = injectedVolume/poreVolume; 
 
         IPV += stepIPV;
-        static bool first = true;
         FILE *recovery;
-        if (first) {
+        if (firstRecoveryOutput_) {
             recovery = fopen(recovery_.c_str(), "w");
-            first = false;
+            firstRecoveryOutput_ = false;
             fprintf(stderr, "# step  currentTime stepSize averageVelocity  stepRecovery  totalRecovery percent_recovery wall_time(min) VPI(t)\n");
             fprintf(recovery, "# step  currentTime  stepSize averageVelocity  stepRecovery  totalRecovery percent_recovery wall_time(min) VPI(t)\n");
         } else {
@@ -634,6 +815,89 @@ public:
         fclose(recovery);
     }
 private:
+    // Episode of the inlet boundary condition at the current time.
+    void updateInletEpisode_()
+    {
+        int epIdx;
+        for (epIdx=0; epIdx < this->episodes_; epIdx++){
+            TRACE( "test: %le <= %le < %le\n", 
+                    this->lowerTimeStepBoundary(epIdx),this->time_ ,
+                    this->upperTimeStepBoundary(epIdx));
+            if (this->time_ >= this->lowerTimeStepBoundary(epIdx)
+                    &&
+                    this->time_ < this->upperTimeStepBoundary(epIdx)
+               )
+            {
+                TRACE("episode %d\n", epIdx);
+                break;
+            }
+        }
+
+        if (currentEpisode_ != epIdx) {
+            DBG("*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*\n"); 
+            DBG("influx injection velocity[%d] = %le\n", 
+                epIdx, this->InjectionVelocity(epIdx));
+            for (int i=0; i<numComponents-2; i++) {
+                DBG("influx Boundary condition switch at %lf s., episode=%d --> %d: particle-%d mole fraction= %le -->%le,\n", 
+                    time_, currentEpisode_, epIdx, i,
+                    this->xParticle(i, currentEpisode_), 
+                    this->xParticle(i, epIdx));
+            }
+            DBG("*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*\n"); 
+            currentEpisode_ = epIdx;
+        }
+    }
+
+    // Index of a face in boundaryFaces_.
+    std::size_t boundaryFaceIndex_(const Element& element, const SubControlVolumeFace& scvf) const
+    {
+        if (isBox)
+            return scvfOffset_[this->fvGridGeometry().elementMapper().index(element)] + scvf.index();
+        return scvf.index();
+    }
+
+    // Box: gradients of the shape functions at the integration point,
+    // as in evalGradients().
+    OutletFace makeOutletFace_(const Element& element,
+                               const ElementGeometry& fvGeometry,
+                               const SubControlVolumeFace& scvf,
+                               std::true_type /*isBox*/) const
+    {
+        const auto geometry = element.geometry();
+        const auto& localBasis = this->fvGridGeometry().feCache().get(geometry.type()).localBasis();
+        using ShapeJacobian = typename std::decay_t<decltype(localBasis)>::Traits::JacobianType;
+
+        const auto ipLocal = geometry.local(scvf.ipGlobal());
+        const auto jacInvT = geometry.jacobianInverseTransposed(ipLocal);
+        std::vector<ShapeJacobian> shapeJacobian;
+        localBasis.evaluateJacobian(ipLocal, shapeJacobian);
+
+        OutletFace outlet;
+        outlet.gradN.resize(shapeJacobian.size());
+        for (std::size_t i = 0; i < shapeJacobian.size(); i++)
+            jacInvT.mv(shapeJacobian[i][0], outlet.gradN[i]);
+
+        outlet.fixedPressure.assign(shapeJacobian.size(), false);
+        for (const auto& otherScvf : scvfs(fvGeometry))
+            if (otherScvf.center()[1] > this->fvGridGeometry().bBoxMax()[1] - eps_)
+                outlet.fixedPressure[fvGeometry.scv(otherScvf.insideScvIdx()).indexInElement()] = true;
+        return outlet;
+    }
+
+    // Cell centered: two point gradient towards the outlet.
+    OutletFace makeOutletFace_(const Element& element,
+                               const ElementGeometry& fvGeometry,
+                               const SubControlVolumeFace& scvf,
+                               std::false_type /*isBox*/) const
+    {
+        const auto& scvCenter = fvGeometry.scv(scvf.insideScvIdx()).center();
+        auto grad = scvf.ipGlobal() - scvCenter;
+        grad /= grad.two_norm2();
+
+        OutletFace outlet;
+        outlet.gradN.assign(1, grad);
+        return outlet;
+    }
 
     std::string recovery_ ;
 
@@ -647,6 +911,21 @@ private:
     int stepIndex_;
     Scalar step_;
     Scalar time_;
+    Scalar temperature_;
+
+    // accumulated by oilRecOutput() and recoveryOutput()
+    mutable Scalar totalRecovery_ = 0.0;
+    mutable Scalar injectedVolume_ = 0.0;
+    mutable Scalar injectedPoreVolumes_ = 0.0;
+    mutable bool firstRecoveryOutput_ = true;
+    mutable time_t recoveryStart_ = 0;
+
+    TimeIntegrationHistory timeIntegrationHistory_;
+    std::vector<NumEqVector> reactionRates_;
+
+    std::vector<std::size_t> scvfOffset_; // box: first face of each element
+    std::vector<BoundaryFaceData> boundaryFaces_;
+    std::vector<OutletFace> outletFaces_;
 public:
     static constexpr Scalar eps_ = 1e-6;
 
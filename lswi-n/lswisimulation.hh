@@ -0,0 +1,786 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+/*!
+ * \file
+ *
+ * \brief The low-salinity water flooding simulation of lswi-n for a given
+ *        number of particles in the brine.
+ *
+ * runSimulation() is a template on the number of particles, which fixes
+ * the number of components (and equations) of the model at compile time.
+ * It is explicitly instantiated for 1 ... LSWI_MAX_PARTICLES (8) particles,
+ * each in a translation unit of its own (lswi-n-particles<n>.cc), and
+ * lswi-n.cc selects the instantiation from Problem.Particles.
+ */
+#ifndef LSWI_SIMULATION_HH
+#define LSWI_SIMULATION_HH
+
+// Further, we include a standard header file for C++, to get time and date information
+#include <ctime>
+// and another one for in- and output.
+#include <iostream>
+// Numeric limits and min/max for the time step control.
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Dumux is based on DUNE, the Distributed and Unified Numerics Environment, 
+// which provides several grid managers and linear solvers. So we need some 
+// includes from that. This program is targeted for dune-2.7.
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/timer.hh>
+#include <dune/grid/io/file/dgfparser/dgfexception.hh>
+#include <dune/grid/io/file/vtk.hh>
+#include <dune/istl/io.hh>
+// In Dumux, a property system is used to specify the model. For this,
+// different properties are defined containing type definitions, values 
+// and methods. All properties are declared in the file `properties.hh`.
+#include <dumux/common/properties.hh>
+// The following file contains the parameter class, which manages the 
+// definition of input parameters by a default value, the inputfile or 
+// the command line.#include <dumux/common/parameters.hh>
+// The file `dumuxmessage.hh` contains the class defining the start and
+// end message of the simulation.#include <dumux/common/dumuxmessage.hh>
+#include <dumux/common/defaultusagemessage.hh>
+// The valgrind header provides memory analysis to avoid leaks and incorrect
+// calls on non initialized code.
+#include <dumux/common/valgrind.hh>
+// Header for amg iterative solver. This solver allows usage of MPI parallel
+// execution.
+#include <dumux/linear/amgbackend.hh>
+// Newton solver for nonlinear part of the algorithm.
+#include <dumux/nonlinear/newtonsolver.hh>
+// Assembler of the matrix which represents the system of equations to be 
+// solved, for finite volume schemes (box-scheme, tpfa-approximation,
+// mpfa-approximation).
+#include <dumux/assembly/fvassembler.hh>
+// The containing class in the following file defines the different 
+// differentiation methods used to compute the derivatives of the residual. 
+#include <dumux/assembly/diffmethod.hh>
+#include <dumux/discretization/method.hh>
+// We need the following class to simplify the writing of dumux simulation 
+// data to VTK format.
+#include <dumux/io/vtkoutputmodule.hh>
+// The gridmanager constructs a grid from the information in the input or 
+// grid file. There is a specification for the different supported grid 
+// managers.
+#include <dumux/io/grid/gridmanager.hh>
+// The following header is required to access solution values to feed to 
+// the Brooks Corey Modified Variable (BCMV) material law.
+#include <dumux/io/loadsolution.hh>
+// Convenience debug/warning/trace preprocesor macros (DBG, WARN, TRACE).
+#include "dumux/common/debugmacros.hh"
+
+// This is a structure to contain the identifier for each particle 
+// and the molecular weight. This structure may well be averted if 
+// a components template is available for the aforementioned particle,
+// but then care must be taken since code considered chemical units
+// (gmol) while component files are specified in SI (kgmol).
+// The structure is used in "dumux/material/fluidsystems/brine-n.hh"
+// and in "lswidata.hh".
+typedef struct particle_t {
+    std::string idx;
+    double molecularWeight;
+}particle_t;
+
+// These are two global variables for simple consecutive 
+// calculations used thus to make code easier to read
+// (defined in lswi-n.cc).
+extern double oilRecovery;
+extern double currentHour;
+// Local input data template:
+#include "lswidata.hh"
+// Spatial parameters:
+#include "lswispatialparams.hh"
+// Problem definition:
+#include "lswiproblem.hh"
+// Newton solver with scaling of the linear system:
+#include "dumux/porousmediumflow/2pncimmiscible/newtonsolver.hh"
+// Episode aware time step control:
+#include "dumux/common/episodetimestepcontroller.hh"
+// Sensitivities of the recovery with respect to stage input values:
+#include "dumux/common/forwardsensitivity.hh"
+// Gradient of the episode rootMS objective by the discrete adjoint:
+#include "dumux/common/adjointgradient.hh"
+// Reaction chemistry by operator splitting (enable with -DLSWI_CHEMISTRY
+// and a reaction network, e.g. -DCACO3_CASO4_MGCO3, as lswi-n1-chemistry
+// in CMakeLists.txt):
+#ifdef LSWI_CHEMISTRY
+#include "dumux/porousmediumflow/2pncimmiscible/chemistrystep.hh"
+#endif
+
+// Newton solver statistics of one episode, to be parsed by shell scripts
+// (failed steps are Newton loops which forced a time step reduction).
+template <class NewtonSolver>
+void reportEpisodeStatistics(const NewtonSolver& nonLinearSolver, int episodeIdx, int steps)
+{
+    const auto& statistics = nonLinearSolver.episodeStatistics();
+    fprintf(stdout, "PARSE episode=%d recovery=%.8lf steps=%d newtonIterations=%d assemblies=%d residualEvaluations=%d failedSteps=%d chops=%d backtracks=%d\n",
+            episodeIdx, oilRecovery, steps,
+            statistics.iterations,
+            statistics.assemblies,
+            statistics.residualEvaluations,
+            statistics.failures,
+            statistics.chops,
+            statistics.backtracks);
+}
+
+// Recovery sensitivities at the end of an episode with a target, to be
+// parsed by shell scripts (dRecovery is in percent per unit of the parameter).
+template <class Sensitivity>
+void reportEpisodeSensitivities(const Sensitivity& sensitivity, int episodeIdx)
+{
+    for (std::size_t j=0; j<sensitivity.numParameters(); j++) {
+        fprintf(stdout, "PARSE sensitivity episode=%d parameter=%s dRecovery=%le\n",
+                episodeIdx, sensitivity.parameter(j).label.c_str(), sensitivity.recovery(j));
+    }
+}
+
+// A run of the finite difference check of the sensitivities
+// (Sensitivity.Check): the stage value of the parameter is changed by
+// delta = step*|value| (step if the value is 0), the run leaves its
+// recovery and rootMS at the end.
+struct SensitivityCheckRun {
+    Dumux::StageParameter parameter;
+    double step;
+    double delta;
+    double recovery;
+    double rootMS;
+};
+
+#ifdef LSWI_CHEMISTRY
+// Thread scaling of the chemistry: wall time of reacting all cells of x
+// over a step dt, repeated n times, with 1, 2, 4, ... threads up to
+// Chemistry.Threads (Chemistry.ScalingBenchmark = n, 0 to skip).
+template <class ChemistryStep, class SolutionVector, class Scalar>
+void benchmarkChemistryScaling(ChemistryStep& chemistryStep, const SolutionVector& x, Scalar dt, int n)
+{
+    const int maxThreads = chemistryStep.numThreads();
+    double serialTime = 0;
+    for (int threads = 1; ; threads = std::min(2*threads, maxThreads)) {
+        const double wallTime = chemistryStep.timeSolve(x, dt, threads, n);
+        if (threads == 1) serialTime = wallTime;
+        fprintf(stdout, "PARSE chemistryScaling threads=%d cells=%zu repetitions=%d wallTime=%lf cellsPerSecond=%le speedup=%lf efficiency=%lf\n",
+                threads, x.size(), n, wallTime,
+                (wallTime > 0)? (double)n*x.size()/wallTime : 0.0,
+                (wallTime > 0)? serialTime/wallTime : 0.0,
+                (wallTime > 0)? serialTime/wallTime/threads : 0.0);
+        if (threads >= maxThreads) break;
+    }
+}
+#endif
+
+// ### One simulation on a given grid.
+//     This function contains the time loop and episode processing.
+//     checkRun is a run of the finite difference check of the
+//     sensitivities, checkRuns are the ones done before this run, as
+//     pairs of -delta and +delta per parameter (see runSimulation()).
+
+template <class TypeTag, class GridGeometry>
+int runOnGrid(std::shared_ptr<GridGeometry> gridGeometry,
+              SensitivityCheckRun *checkRun = nullptr,
+              const std::vector<SensitivityCheckRun>& checkRuns = {})
+{
+    using namespace Dumux;
+
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+
+    // The grid view of the grid geometry.
+    const auto& leafGridView = gridGeometry->gridView();
+
+    // Get problem definition from the properties namespace
+    // defined in the "lswiproblem.hh file".
+    using Problem = GetPropType<TypeTag, Properties::Problem>;
+    auto problem = std::make_shared<Problem>(gridGeometry);
+    if (checkRun) {
+        auto& spatialParams = problem->spatialParams();
+        const auto& p = checkRun->parameter;
+        const Scalar value = spatialParams.stageValue(p.stage, p.name);
+        checkRun->delta = checkRun->step*((std::abs(value) > 0)? std::abs(value) : 1.0);
+        spatialParams.setStageValue(p.stage, p.name, value + checkRun->delta);
+        fprintf(stdout, "PARSE sensitivityCheckRun parameter=%s value=%le delta=%le\n",
+                p.label.c_str(), value, checkRun->delta);
+    }
+
+    // Check if we are about to restart a previously interrupted simulation.
+    // Beware that in Dumux 3.0 restart data is in float format, so
+    // that double precision is not restored. This may lead to different
+    // results or even program termination. If item is not found on 
+    // input file, or commented out, value will default to 0
+    // (as seen in getParam<type>() call.
+    Scalar restartTime = getParam<Scalar>("Restart.Time", 0);
+    int restartStep = getParam<int>("Restart.Step", 0);
+    
+    // Define the solution vector.
+    using SolutionVector = GetPropType<TypeTag, Properties::SolutionVector>;
+    SolutionVector x(gridGeometry->numDofs());
+    // Apply the initial solution or the restart solution.
+    if (restartTime > 0)
+    {
+        using IOFields = GetPropType<TypeTag, Properties::IOFields>;
+        using PrimaryVariables = GetPropType<TypeTag, Properties::PrimaryVariables>;
+        using ModelTraits = GetPropType<TypeTag, Properties::ModelTraits>;
+        using FluidSystem = GetPropType<TypeTag, Properties::FluidSystem>;
+        const auto fileName = getParam<std::string>("Restart.File");
+        const auto pvName = createPVNameFunction<IOFields, PrimaryVariables, ModelTraits, FluidSystem>();
+        loadSolution(x, fileName, pvName, *gridGeometry);
+    }
+    else {
+        problem->applyInitialSolution(x);
+    }
+
+    // Initialize the grid variables with the initial solution or
+    // the restart solution if restart time specified. If restart
+    // time has been specified, then the file containing the restart
+    // solution must be specified in the input file with "Restart.File".
+    // For this particular example, a "Restart.Recovery" and 
+    // "Restart.Step" must also be specified, but would not be
+    // necessary in a different problem.
+    auto xOld = x;
+    // the grid variables
+    using GridVariables = GetPropType<TypeTag, Properties::GridVariables>;
+    auto gridVariables = std::make_shared<GridVariables>(problem, gridGeometry);
+    gridVariables->init(x, xOld);
+
+    // Time loop parameters:
+    // DtInitial: size of the initial value for delta_t in march method (seconds)
+    // MaxTimeStepSize: limit for size of delta_t to grow in adaptative method.
+    // TEnd: End of simulation, in seconds.
+    // Default value for MaxTimeStep is 1e100 (no limit). 
+    using Scalar = GetPropType<TypeTag, Properties::Scalar>;
+    auto dt = getParam<Scalar>("TimeLoop.DtInitial");
+    const auto maxDt = getParam<Scalar>("TimeLoop.MaxTimeStepSize");
+    const auto tEnd = getParam<Scalar>("TimeLoop.TEnd");
+    // const auto maxDivisions = getParam<int>("TimeLoop.MaxTimeStepDivisions");
+    //////////////////////////////////////////////////////////////
+    // intialize the vtk output module
+    using IOFields = GetPropType<TypeTag, Properties::IOFields>;
+    VtkOutputModule<GridVariables, SolutionVector> vtkWriter(*gridVariables, x, problem->name());   
+    
+    using VelocityOutput = GetPropType<TypeTag, Properties::VelocityOutput>;
+    vtkWriter.addVelocityOutput(std::make_shared<VelocityOutput>(*gridVariables));
+    IOFields::initOutputModule(vtkWriter); //! Add model specific output fields
+    vtkWriter.write(0.0);
+    ///////////////////////////////////////////////////////////
+
+    // instantiate time loop
+    auto timeLoop = std::make_shared<TimeLoop<Scalar>>(restartTime, dt, tEnd);
+
+    // the assembler with time loop for instationary problem
+    using Assembler = FVAssembler<TypeTag, DiffMethod::numeric>;
+    auto assembler = std::make_shared<Assembler>(problem, gridGeometry, gridVariables, timeLoop);
+
+    // // the linear solver
+    // using LinearSolver = AMGBackend<TypeTag>;
+    // auto linearSolver =  std::make_shared<LinearSolver>(leafGridView, gridGeometry->dofMapper());
+    using LinearSolver = UMFPackBackend;
+    auto linearSolver =  std::make_shared<LinearSolver>();
+
+    // the non-linear solver (row/column scaling is enabled with
+    // Newton.EnableScaling, reference magnitudes come from the problem).
+    using NewtonSolver = TwoPNCImmiscibleNewtonSolver<Assembler, LinearSolver,
+                                                      GetPropType<TypeTag, Properties::ModelTraits>>;
+
+    // NewtonMethod nonLinearSolver(newtonController, assembler, linearSolver);
+    NewtonSolver nonLinearSolver(assembler, linearSolver);
+    nonLinearSolver.setPrimaryVariableScaling(problem->primaryVariableReference());
+    if (nonLinearSolver.scalingEnabled()) {
+        auto reference = problem->primaryVariableReference();
+        for (int i=0; i<reference.size(); i++)
+            DBG("Newton scaling: reference magnitude of primary variable %d = %le\n", i, reference[i]);
+    }
+            
+    // time loop
+    int currentEpisodeIndex=0; 
+    timeLoop->start(); 
+    problem->setTime(timeLoop->timeStepIndex(),timeLoop->time(),timeLoop->timeStepSize());
+    TRACE("Problem time index %d, time= %lf,  step size= %lf\n###############################\n", 
+        timeLoop->timeStepIndex(),timeLoop->time(),timeLoop->timeStepSize());
+
+    Scalar errorSum = 0;
+    Scalar rootMS = 0;
+
+    auto timeLimit = getParam<time_t>("TimeLoop.timeLimit", 0.0);
+    time_t start=time(NULL);
+    if (timeLimit > 0){ 
+        WARN("Program execution time limit set from input file to %lu minutes\n",
+                timeLimit);
+    }
+    if(problem->episodeCount()) {
+        timeLoop->setMaxTimeStepSize(problem->getMaxTimeStepSize(0));
+    } else {
+        timeLoop->setMaxTimeStepSize(problem->getMaxTimeStepSize());
+    }
+
+    // Episode aware time step controller (TimeLoop.UseEpisodeController).
+    // The salinity front moves in y-direction, the cell size is the
+    // smallest element extent in that direction.
+    EpisodeTimeStepController<Scalar> timeStepController;
+    {
+        Scalar cellSize = std::numeric_limits<Scalar>::max();
+        for (const auto& element : elements(leafGridView)) {
+            const auto geometry = element.geometry();
+            Scalar yMin = geometry.corner(0)[1], yMax = yMin;
+            for (int i=1; i<geometry.corners(); i++) {
+                yMin = std::min(yMin, geometry.corner(i)[1]);
+                yMax = std::max(yMax, geometry.corner(i)[1]);
+            }
+            cellSize = std::min(cellSize, yMax - yMin);
+        }
+        timeStepController.setGeometry(gridGeometry->bBoxMax()[1] - gridGeometry->bBoxMin()[1], cellSize);
+    }
+    if (timeStepController.enabled() && problem->episodeCount()) {
+        timeLoop->setTimeStepSize(timeStepController.beginEpisode(timeLoop->time(),
+                    problem->salinityFrontSpeed(0), dt, problem->getMaxTimeStepSize(0)));
+    }
+    int episodeSteps = 0;
+    Scalar lastRecoveryRate = 0;
+
+    // Variable step BDF2 storage term (TimeLoop.Scheme = BDF2): the local
+    // residual is needed to evaluate the storage of the old time levels.
+    using LocalResidual = GetPropType<TypeTag, Properties::LocalResidual>;
+    LocalResidual localResidual(problem.get(), timeLoop.get());
+    auto& timeIntegrationHistory = problem->timeIntegrationHistory();
+    Scalar bdf2Dt = std::numeric_limits<Scalar>::max();
+    if (timeIntegrationHistory.enabled()) {
+        DBG("Time integration: variable step BDF2\n");
+    }
+
+    // Forward sensitivities of the recovery (Sensitivity.Parameters).
+    ForwardSensitivity<TypeTag, Assembler, LinearSolver> sensitivity(*problem, *gridVariables,
+                                                                     *assembler, *linearSolver);
+    if (checkRun) sensitivity.disable();
+    if (sensitivity.enabled() && timeIntegrationHistory.enabled())
+        DUNE_THROW(Dune::InvalidStateException, "Sensitivities require TimeLoop.Scheme = ImplicitEuler");
+
+    // Adjoint gradient of rootMS (Adjoint.Parameters), the forward run
+    // keeps a checkpoint of every step.
+    AdjointGradient<TypeTag, Assembler, LinearSolver> adjoint(problem, gridGeometry, gridVariables,
+                                                             *linearSolver);
+    if (checkRun) adjoint.disable();
+    if (adjoint.enabled() && timeIntegrationHistory.enabled())
+        DUNE_THROW(Dune::InvalidStateException, "The adjoint requires TimeLoop.Scheme = ImplicitEuler");
+#ifdef LSWI_CHEMISTRY
+    // Chemistry of all cells (Chemistry.Threads), coupled to the transport
+    // according to Chemistry.Coupling:
+    //   Split:  react after each transport step (default)
+    //   Source: reaction sources of the transport, evaluated once per
+    //           time step at its start
+    //   Newton: reaction sources evaluated once per Newton iteration,
+    //           with the activities of the time step start
+    // The adjoint replays the transport steps only, it does not
+    // differentiate the chemistry.
+    if (adjoint.enabled())
+        DUNE_THROW(Dune::InvalidStateException, "The adjoint is not available with the chemistry (LSWI_CHEMISTRY)");
+    ChemistryStep<TypeTag> chemistryStep(*problem);
+    chemistryStep.setBrineDensity(problem->injectionDensity(0));
+    const auto chemistryCoupling = getParam<std::string>("Chemistry.Coupling", "Split");
+    if (chemistryCoupling != "Split" && chemistryCoupling != "Source" && chemistryCoupling != "Newton")
+        DUNE_THROW(Dune::InvalidStateException, "Chemistry.Coupling must be Split, Source or Newton, not "
+                   << chemistryCoupling);
+    const bool reactiveSource = (chemistryCoupling != "Split");
+    const int chemistryBenchmark = getParam<int>("Chemistry.ScalingBenchmark", 0);
+    if (chemistryBenchmark > 0)
+        benchmarkChemistryScaling(chemistryStep, x, dt, chemistryBenchmark);
+    if (chemistryCoupling == "Newton") {
+        nonLinearSolver.setIterationHook([&](const SolutionVector& u){
+            chemistryStep.rates(u, problem->reactionRates(), true);
+        });
+    }
+#endif
+    
+    do
+    {
+        if (timeLimit && time(NULL) > timeLimit){
+            DBG("PARSE_T time limit (%ld minutes)for execution reached. Abort.\n", (long)(timeLimit - start)/60);
+            exit(1);
+        }
+        // Set current hour:
+        currentHour = timeLoop->time()/3600.0;
+        // Are we done with last episode?
+        if (timeLoop->time() >=  problem->getUpperTimeStepBoundary(problem->episodeCount() - 1)){
+            auto target = problem->getTarget(currentEpisodeIndex);
+            DBG("Last episode %d (stage %d) time limit (%lf hours) has been reached.\n", 
+                    problem->episodeCount(), 
+                    problem->stageCount(), 
+                    problem->getUpperTimeStepBoundary(problem->episodeCount() - 1)/3600);
+            DBG("episode[%d] recovery/target=%lf/%lf error=%le\n",
+                    currentEpisodeIndex, oilRecovery,
+                    target, 
+                    target>0?
+                      fabs(problem->getTarget(currentEpisodeIndex) - oilRecovery):
+                          -1.0); 
+            if (problem->episodeCount() and problem->getTarget(currentEpisodeIndex)>0) {
+                auto error = fabs(problem->getTarget(currentEpisodeIndex) - oilRecovery);
+                errorSum += error;
+                rootMS += (error*error);
+                DBG("PARSE episode=%d  error=%lf avgError=%lf rootMS=%lf time=%ld\n",
+                    currentEpisodeIndex, error, errorSum/(currentEpisodeIndex+1),
+                    sqrt(rootMS),
+                    (long)(time(NULL)-start)/60);
+                sensitivity.addEpisodeError(oilRecovery, problem->getTarget(currentEpisodeIndex));
+                adjoint.addEpisodeError(currentEpisodeIndex, oilRecovery, problem->getTarget(currentEpisodeIndex));
+                reportEpisodeSensitivities(sensitivity, currentEpisodeIndex);
+            } 
+            reportEpisodeStatistics(nonLinearSolver, currentEpisodeIndex, episodeSteps);
+            break;
+        }
+
+        // Determine episode index.
+        int episodeIndex = 0;
+        for (int idx=0; idx<problem->episodeCount(); idx++){
+            if (timeLoop->time() < problem->getUpperTimeStepBoundary(idx) - problem->eps_ 
+                    &&
+                timeLoop->time() >= problem->getLowerTimeStepBoundary(idx))
+            {
+                episodeIndex=idx;
+                break;
+            }
+        }
+        DBG("Step=%d episode=%d (%s) current=%d, time=%lf, timestep=%lf nexttime=%lf \n",
+                timeLoop->timeStepIndex() + restartStep,  
+                episodeIndex+1, 
+                problem->episodeStageName(episodeIndex).c_str(),
+                currentEpisodeIndex+1,
+                timeLoop->time(),timeLoop->timeStepSize(),
+                timeLoop->time()+timeLoop->timeStepSize() );
+       
+        if (timeLoop->timeStepIndex()  == 2) {
+            DBG("******   dump  ******\n");
+            problem->spatialParams().dump();
+        }
+
+
+        if (episodeIndex != currentEpisodeIndex){
+            DBG("setting maxTimeStepSize to %le\n", problem->getMaxTimeStepSize(episodeIndex));
+            timeLoop->setMaxTimeStepSize(problem->getMaxTimeStepSize(episodeIndex));
+            DBG("*** timeLoop: episode switch %d --> %d at %lf s.\n", 
+                    currentEpisodeIndex, episodeIndex, timeLoop->time());
+            auto target = problem->getTarget(currentEpisodeIndex);
+            DBG("episode[%d] recovery/target=%lf/%lf error=%le\n",
+
+                    currentEpisodeIndex, oilRecovery,
+                    target, 
+                    target>0?
+                      fabs(problem->getTarget(currentEpisodeIndex) - oilRecovery):
+                          -1.0); 
+            if (problem->getTarget(currentEpisodeIndex)>0) {
+                auto error = fabs(problem->getTarget(currentEpisodeIndex) - oilRecovery);
+                errorSum += error;
+                rootMS += (error*error);
+                fprintf(stdout, "PARSE episode=%d  error=%lf avgError=%lf rootMS=%lf time=%ld\n",
+                    currentEpisodeIndex, error, errorSum/(currentEpisodeIndex+1),
+                    sqrt(rootMS),
+                    (long)(time(NULL)-start)/60);
+/*                fprintf(stdout, "PARSE episode=%d  error=%lf avgError=%lf rootMS=%lf\n",
+                    currentEpisodeIndex, error, errorSum/(currentEpisodeIndex+1),
+                    sqrt(rootMS));*/
+                sensitivity.addEpisodeError(oilRecovery, problem->getTarget(currentEpisodeIndex));
+                adjoint.addEpisodeError(currentEpisodeIndex, oilRecovery, problem->getTarget(currentEpisodeIndex));
+                reportEpisodeSensitivities(sensitivity, currentEpisodeIndex);
+            } 
+            reportEpisodeStatistics(nonLinearSolver, currentEpisodeIndex, episodeSteps);
+            nonLinearSolver.resetEpisodeStatistics();
+            episodeSteps = 0;
+            currentEpisodeIndex = episodeIndex;
+            // The boundary conditions change discontinuously, the first
+            // step of the episode is an implicit Euler step.
+            timeIntegrationHistory.reset();
+            bdf2Dt = std::numeric_limits<Scalar>::max();
+            // set episode material law parameters, fluidsystem
+            // densities and viscosities
+            DBG("----timeLoop---- Setting episode parameters...\n");
+            problem->setEpisode(currentEpisodeIndex);
+            // the (cached) volume variables of both time levels belong
+            // to the previous episode
+            gridVariables->init(x, xOld);
+#ifdef LSWI_CHEMISTRY
+            chemistryStep.setBrineDensity(problem->injectionDensity(currentEpisodeIndex));
+#endif
+            // Set initial timestep for episode...
+            TRACE("timeLoop: Setting initial timestep size for next episode to %lf...\n",
+                    problem->getDtInitial(currentEpisodeIndex));
+            if (timeStepController.enabled()) {
+                auto episodeDt = timeStepController.beginEpisode(timeLoop->time(),
+                        problem->salinityFrontSpeed(currentEpisodeIndex),
+                        problem->getDtInitial(currentEpisodeIndex),
+                        problem->getMaxTimeStepSize(currentEpisodeIndex));
+                DBG("timeLoop: episode controller restarts with step size %le\n", episodeDt);
+                timeLoop->setTimeStepSize(episodeDt);
+            } else {
+                timeLoop->setTimeStepSize(problem->getDtInitial(currentEpisodeIndex));    
+            }
+        }
+
+        // check if timestep does not overshoot episode end
+        auto upperTime = (problem->episodeCount())?
+            problem->getUpperTimeStepBoundary(currentEpisodeIndex):problem->getTEnd();
+
+        if (timeLoop->time()+timeLoop->timeStepSize() - upperTime > problem->eps_){
+            // If initial timestep size overreaches, reset timestep.
+            timeLoop->setTimeStepSize(upperTime - timeLoop->time());    
+            DBG("timeLoop: *** limiting time step to end of episode:  max step=%le\n", 
+                timeLoop->timeStepSize());
+        }    
+
+        // relax the Newton tolerances away from the episode target time
+        // (Newton.GoalOriented)
+        if (nonLinearSolver.goalOriented()) {
+            auto lowerTime = (problem->episodeCount())?
+                problem->getLowerTimeStepBoundary(currentEpisodeIndex):0.0;
+            auto episodeEnd = std::min(upperTime, tEnd);
+            nonLinearSolver.adaptToleranceToGoal(episodeEnd - timeLoop->time(),
+                    episodeEnd - lowerTime, timeLoop->timeStepSize(), lastRecoveryRate);
+            TRACE("Newton tolerance relaxation %le (recovery rate %le %%/s)\n",
+                    nonLinearSolver.toleranceRelaxation(), lastRecoveryRate);
+        }
+
+        // set previous solution for storage evaluations
+        assembler->setPreviousSolution(xOld);
+#ifdef LSWI_CHEMISTRY
+        // lagged reaction sources (and activities) of the step
+        if (reactiveSource)
+            chemistryStep.rates(x, problem->reactionRates());
+#endif
+
+        // solve the non-linear system with time step control
+        // (linear solves of the step include those of retries with a smaller dt)
+        const int linearSolvesBefore = nonLinearSolver.numLinearSolves();
+        nonLinearSolver.solve(x, *timeLoop);
+        DBG("Newton iterations=%d linear solves=%d (run total %d/%d) scaled shift=%le scaled residual=%le\n",
+                nonLinearSolver.lastIterations(),
+                nonLinearSolver.numLinearSolves() - linearSolvesBefore,
+                nonLinearSolver.numIterations(),
+                nonLinearSolver.numLinearSolves(),
+                nonLinearSolver.scaledShift(),
+                nonLinearSolver.scaledResidual());
+
+        // sensitivities of the step (before the chemistry of a split step)
+        sensitivity.step(x, xOld, timeLoop->timeStepSize());
+        adjoint.recordStep(xOld, timeLoop->time(), timeLoop->timeStepSize(),
+                           timeLoop->timeStepIndex(), currentEpisodeIndex);
+
+        // error estimate of the BDF2 step and shift of the time levels
+        if (timeIntegrationHistory.enabled()) {
+            auto stepSize = timeLoop->timeStepSize();
+            auto error = timeIntegrationHistory.estimateError(x, xOld, stepSize,
+                    problem->primaryVariableReference());
+            bdf2Dt = timeIntegrationHistory.suggestTimeStepSize(stepSize, error);
+            TRACE("BDF2 error estimate %le, suggested step size %le\n", error, bdf2Dt);
+            timeIntegrationHistory.advance(*problem, *gridVariables, localResidual, xOld, stepSize);
+        }
+
+#ifdef LSWI_CHEMISTRY
+        // react over the step and update the volume variables
+        if (!reactiveSource) {
+            chemistryStep.apply(x, timeLoop->timeStepSize());
+            gridVariables->update(x);
+        }
+#endif
+
+        // make the new solution the old solution
+        xOld = x;
+        gridVariables->advanceTimeStep();
+
+        // advance to the time loop to the next step
+        Scalar lastTimeStepSize = timeLoop->timeStepSize();
+        timeLoop->advanceTimeStep();
+        TRACE("timeLoop:  time loop now at index=%d time=%lf (step size pending, currently at %lf)\n",
+                timeLoop->timeStepIndex(),timeLoop->time(),timeLoop->timeStepSize());
+
+        // write vtk output
+        vtkWriter.write(timeLoop->time());
+        // report statistics of this time step
+        timeLoop->reportTimeStep();
+
+
+        // This is for the recovery output...
+        problem->setTime(timeLoop->timeStepIndex(),timeLoop->time(),lastTimeStepSize);
+        // Now we can do the recovery output...
+        auto recoveryBefore = oilRecovery;
+        problem->oilRecOutput(gridVariables->curGridVolVars(), x, currentEpisodeIndex);
+        lastRecoveryRate = (oilRecovery - recoveryBefore)/lastTimeStepSize;
+
+        episodeSteps++;
+
+        // set new dt as suggested by newton controller
+        // (and the BDF2 error estimate)
+        auto newtonDt = nonLinearSolver.suggestTimeStepSize(timeLoop->timeStepSize());
+        if (timeIntegrationHistory.enabled()) newtonDt = std::min(newtonDt, bdf2Dt);
+        if (timeStepController.enabled()) {
+            // ... combined with the episode aware controller
+            timeStepController.stepAccepted(lastTimeStepSize, oilRecovery);
+            auto episodeEnd = std::min(upperTime, tEnd);
+            auto nextDt = timeStepController.suggestTimeStepSize(timeLoop->time(), newtonDt, episodeEnd);
+            TRACE("timeLoop: newton suggests %le, episode controller %le (steady=%d)\n",
+                    newtonDt, nextDt, (int)timeStepController.steadyState(timeLoop->time()));
+            timeLoop->setTimeStepSize(nextDt);
+        } else {
+            timeLoop->setTimeStepSize(newtonDt);
+        }
+        
+    } while (!timeLoop->finished());
+
+    timeLoop->finalize(leafGridView.comm());
+
+    const auto& runStatistics = nonLinearSolver.runStatistics();
+    fprintf(stdout, "PARSE steps=%d newtonIterations=%d linearSolves=%d assemblies=%d residualEvaluations=%d failedSteps=%d avgNewton=%lf scaling=%d\n",
+            timeLoop->timeStepIndex(),
+            runStatistics.iterations,
+            runStatistics.linearSolves,
+            runStatistics.assemblies,
+            runStatistics.residualEvaluations,
+            runStatistics.failures,
+            timeLoop->timeStepIndex()?
+              (double)runStatistics.iterations/timeLoop->timeStepIndex(): 0.0,
+            (int)nonLinearSolver.scalingEnabled());
+    for (std::size_t j=0; j<sensitivity.numParameters(); j++) {
+        fprintf(stdout, "PARSE gradient parameter=%s dRecovery=%le dRootMS=%le\n",
+                sensitivity.parameter(j).label.c_str(), sensitivity.recovery(j),
+                sensitivity.rootMSGradient(j, sqrt(rootMS)));
+    }
+    // Central finite differences of the check runs, relative errors
+    // |sensitivity - difference|/max(|sensitivity|, |difference|).
+    for (std::size_t j=0; j<sensitivity.numParameters() && 2*j+1<checkRuns.size(); j++) {
+        const auto& minus = checkRuns[2*j];
+        const auto& plus = checkRuns[2*j+1];
+        const double width = plus.delta - minus.delta;
+        const double dRecovery = sensitivity.recovery(j);
+        const double dRootMS = sensitivity.rootMSGradient(j, sqrt(rootMS));
+        const double recoveryDifference = (plus.recovery - minus.recovery)/width;
+        const double rootMSDifference = (plus.rootMS - minus.rootMS)/width;
+        const double recoveryScale = std::max(std::abs(dRecovery), std::abs(recoveryDifference));
+        const double rootMSScale = std::max(std::abs(dRootMS), std::abs(rootMSDifference));
+        fprintf(stdout, "PARSE sensitivityCheck parameter=%s delta=%le dRecovery=%le finiteDifference=%le relativeError=%le dRootMS=%le rootMSFiniteDifference=%le rootMSRelativeError=%le\n",
+                sensitivity.parameter(j).label.c_str(), 0.5*width,
+                dRecovery, recoveryDifference,
+                (recoveryScale > 0)? std::abs(dRecovery - recoveryDifference)/recoveryScale : 0.0,
+                dRootMS, rootMSDifference,
+                (rootMSScale > 0)? std::abs(dRootMS - rootMSDifference)/rootMSScale : 0.0);
+    }
+    if (checkRun) {
+        checkRun->recovery = oilRecovery;
+        checkRun->rootMS = sqrt(rootMS);
+    }
+    using VolumeVariables = GetPropType<TypeTag, Properties::VolumeVariables>;
+    fprintf(stdout, "PARSE assembly time=%lf timePerAssembly=%le volVarsBytes=%zu fluidStateBytes=%zu cachedVolVars=%d\n",
+            runStatistics.assemblyTime,
+            (runStatistics.assemblies)? runStatistics.assemblyTime/runStatistics.assemblies : 0.0,
+            sizeof(VolumeVariables),
+            sizeof(typename VolumeVariables::FluidState),
+            (int)getPropValue<TypeTag, Properties::EnableGridVolumeVariablesCache>());
+    if (adjoint.enabled()) {
+        Dune::Timer adjointTimer;
+        adjoint.compute(x);
+        std::string gradient;
+        for (std::size_t j=0; j<adjoint.numParameters(); j++) {
+            fprintf(stdout, "PARSE adjointGradient parameter=%s dRootMS=%le\n",
+                    adjoint.parameter(j).label.c_str(), adjoint.gradient(j));
+            char value[32];
+            snprintf(value, sizeof(value), "%s%le", j? ",":"", adjoint.gradient(j));
+            gradient += value;
+        }
+        fprintf(stdout, "PARSE adjoint steps=%zu checkpointBytes=%zu rootMS=%le wallTime=%lf gradient=%s\n",
+                adjoint.numSteps(), adjoint.checkpointBytes(), adjoint.objective(),
+                adjointTimer.elapsed(), gradient.c_str());
+    }
+#ifdef LSWI_CHEMISTRY
+    const auto& chemistryStatistics = chemistryStep.statistics();
+    fprintf(stdout, "PARSE chemistry threads=%d steps=%d rateUpdates=%d cells=%ld speciationIterations=%ld failedCells=%ld correctedCells=%ld cacheHits=%ld cacheMisses=%ld tableHits=%ld tableLookups=%ld odeSubsteps=%ld odeRejected=%ld wallTime=%lf timePerCell=%le\n",
+            chemistryStep.numThreads(),
+            chemistryStatistics.steps,
+            chemistryStatistics.rateUpdates,
+            chemistryStatistics.cells,
+            chemistryStatistics.iterations,
+            chemistryStatistics.failed,
+            chemistryStatistics.corrected,
+            chemistryStatistics.cacheHits,
+            chemistryStatistics.cacheMisses,
+            chemistryStatistics.tableHits,
+            chemistryStatistics.tableLookups,
+            chemistryStatistics.odeSubsteps,
+            chemistryStatistics.odeRejected,
+            chemistryStatistics.wallTime,
+            (chemistryStatistics.cells)? chemistryStatistics.wallTime/chemistryStatistics.cells : 0.0);
+#endif
+
+    return 0;
+} // end runOnGrid
+
+// ### The simulation.
+//     This function creates the grid and runs the simulation on it.
+
+template <int numParticles>
+int runSimulation(int argc, char** argv)
+{
+    DBG("particles= %d\n", numParticles);
+    using namespace Dumux;
+
+    // Define the type tag for this problem.
+    using TypeTag = Properties::TTag::LSWFBoxParticlesTypeTag<numParticles>;
+
+    // Create and initialize grid (from the given grid file or the input 
+    // file definitions).
+    // This makes use of 3.0 GridManager template.
+    GridManager<GetPropType<TypeTag, Properties::Grid> > gridManager;
+    gridManager.init();
+
+    ////////////////////////////////////////////////////////////
+    // Run instationary non-linear problem on this grid.
+    ////////////////////////////////////////////////////////////
+
+    // Compute on the leaf grid view.
+    const auto& leafGridView = gridManager.grid().leafGridView();
+
+    // Create the finite volume grid geometry as a shared pointer
+    // and update.
+    using GridGeometry = GetPropType<TypeTag, Properties::GridGeometry>;
+    auto gridGeometry = std::make_shared<GridGeometry>(leafGridView);
+    gridGeometry->update();
+
+    // Finite difference check of the sensitivities (Sensitivity.Check):
+    // two full runs per parameter of Sensitivity.Parameters, with its stage
+    // value changed by -delta and +delta. They are done before the run
+    // itself, whose output files are written last. Each run takes its own
+    // time steps, so the difference also contains their error: use small
+    // steps and tight Newton tolerances, with a CheckStep well above them.
+    std::vector<SensitivityCheckRun> checkRuns;
+    if (getParam<bool>("Sensitivity.Check", false) && hasParam("Sensitivity.Parameters")) {
+        const auto step = getParam<double>("Sensitivity.CheckStep", 1e-3);
+        for (const auto& label : getParam<std::vector<std::string>>("Sensitivity.Parameters")) {
+            for (double sign : {-1.0, 1.0}) {
+                SensitivityCheckRun checkRun{parseStageParameter(label, "Sensitivity.Parameters"), sign*step, 0.0, 0.0, 0.0};
+                oilRecovery = 0;
+                currentHour = 0;
+                const int status = runOnGrid<TypeTag>(gridGeometry, &checkRun);
+                if (status != 0) return status;
+                checkRuns.push_back(checkRun);
+            }
+        }
+        oilRecovery = 0;
+        currentHour = 0;
+    }
+
+    return runOnGrid<TypeTag>(gridGeometry, nullptr, checkRuns);
+} // end runSimulation
+
+#endif
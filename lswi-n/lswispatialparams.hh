@@ -26,6 +26,8 @@
 #ifndef LSWI_SPATIAL_PARAMS_HH
 #define LSWI_SPATIAL_PARAMS_HH
 
+#include <string>
+
 #include <dumux/porousmediumflow/properties.hh>
 #include <dumux/material/spatialparams/fv.hh>
 
@@ -78,12 +80,20 @@ class LSWF2pncSpatialParams :
     using EffectiveLaw = RegularizedModifiedBrooksCoreyFI<Scalar>;
 
     static constexpr int dimWorld = GridView::dimensionworld;
-    mutable int episode_;
+    int episode_;
     mutable int step_;
 public:
+    /*!
+     * \brief Set the episode of the material law parameters and the
+     *        permeability.
+     *
+     * The parameters of the episode are computed here, once, so that
+     * materialLawParams() only depends on the episode and the solution.
+     * Volume variables computed before the switch are out of date.
+     */
     void setEpisode(int value){
         DBG("****setEpisode***** spatial params set episode to %d (%s)\n", value, this->episodeName(value).c_str());
-        episode_ = value;
+        updateEpisodeParams_(value);
     }
     void setStep(int value){
         DBG("**setStep** spatial params set step to %d\n", value);
@@ -109,7 +119,14 @@ public:
     LSWF2pncSpatialParams(std::shared_ptr<const GridGeometry> fvGridGeometry)
     : ParentType(fvGridGeometry)
     {
-        episode_ = 0;
+        episode_ = -1;
+        lastInputSalinity_ = -1;
+        highSalinityStage_ = -1;
+        brineDensity_ = -1;
+        brineViscosity_ = -1;
+        // Episode defined value not available...
+        // Problem considers constant porosity (no geomechanics)
+        porosity_ = this->getValue("MatrixPorosity");
         int i=0;
         // Initial high salinity values.
         materialParams_.setPe_HS(this->getValue("MatrixPe"));
@@ -140,6 +157,7 @@ public:
         // Set the initial salinity to initial conditions.
         //materialParams_.setS(this->getValue("xNa"));
         materialParams_.setS(this->xParticleInitialTotal());
+        updateEpisodeParams_(0);
     }
 
     /*!
@@ -159,10 +177,7 @@ public:
      */
     Scalar porosityAtPos(const GlobalPosition& globalPos) const
     {
-         // Episode defined value not available...
-         // Problem considers constant porosity (no geomechanics)
-        static Scalar initialPhi = this->getValue("MatrixPorosity");
-        return initialPhi;
+        return porosity_;
     }
 
     /*!
@@ -175,46 +190,203 @@ public:
         return this->stageNumber(k);
     }
 
+    /*!
+     * \brief The material law parameters of the current episode
+     *
+     * With BCM the parameters of the episode are used as they are.
+     * Otherwise the law interpolates between the high and the low
+     * salinity values by the total salinity of the solution at the scv,
+     * which is set on a copy: the result only depends on the episode and
+     * the element solution.
+     */
     template<class ElementSolution, class Problem>
-    const MaterialLawParams& materialLawParams(const Element& element,
-                                           const Problem& problem,
-                                           const SubControlVolume& scv,
-                                           const ElementSolution& elemSol) const
-   {
-        static int episode = -1;
-
-        // First of all, if episode has not changed, then there is no
-        // need to reset any parameter (with BCM only).
-        bool episodeSwitch = (this->episode_ != episode);
-        if (this->useBCM_ and not episodeSwitch) return materialParams_;
-
-        episode = this->episode_;
-        if (episodeSwitch) DBG("***---   SpatialParams at episode %d, stage=%d\n", 
-                    episode, this->stageNumber(episode));
-                
-        int i = episode;
+    MaterialLawParams materialLawParams(const Element& element,
+                                        const Problem& problem,
+                                        const SubControlVolume& scv,
+                                        const ElementSolution& elemSol) const
+    {
+        if (this->useBCM_) return materialParams_;
+
+        // Salinity is set to solution salinity value at element.
+        Scalar totalSalinity = 0.0;      
+        for (int compIdx = 1; compIdx < FluidSystem::numComponents-1; ++compIdx)
+        {
+            totalSalinity += elemSol[scv.indexInElement()][compIdx];
+        }
+        MaterialLawParams params(materialParams_);
+        params.setS(totalSalinity);
+        return params;
+    }
+
+    // Material law parameters of the current episode, with the
+    // salinity of the episode.
+    const MaterialLawParams& episodeMaterialLawParams() const
+    { return materialParams_; }
+
+    /*!
+     * \brief Set the brine density \f$\mathrm{[kg/m^3]}\f$ and viscosity
+     *        \f$\mathrm{[Pa s]}\f$ of the episode.
+     *
+     * The volume variables pass them to the fluid system with its
+     * parameter cache (see TwoPNCImmiscible::ParameterCache). Values <= 0
+     * leave the defaults of the brine fluid system.
+     */
+    void setEpisodeBrine(Scalar density, Scalar viscosity)
+    {
+        brineDensity_ = density;
+        brineViscosity_ = viscosity;
+    }
+
+    Scalar episodeBrineDensity() const
+    { return brineDensity_; }
+
+    Scalar episodeBrineViscosity() const
+    { return brineViscosity_; }
+
+    //! The state of the episode parameters, see setEpisodeState()
+    struct EpisodeState {
+        int episode;
+        Scalar lastInputSalinity;
+        int highSalinityStage;
+        Scalar brineDensity;
+        Scalar brineViscosity;
+    };
+
+    EpisodeState episodeState() const
+    { return {episode_, lastInputSalinity_, highSalinityStage_, brineDensity_, brineViscosity_}; }
+
+    /*!
+     * \brief Go back to the parameters of an earlier episode state.
+     *
+     * setEpisode() enters the episodes in order, this also works backwards
+     * in time (adjoint).
+     */
+    void setEpisodeState(const EpisodeState& state)
+    {
+        episode_ = state.episode;
+        lastInputSalinity_ = state.lastInputSalinity;
+        highSalinityStage_ = state.highSalinityStage;
+        brineDensity_ = state.brineDensity;
+        brineViscosity_ = state.brineViscosity;
+        setEpisodeMaterialParams_();
+    }
+
+    /*!
+     * \brief Input value of a stage which is read per episode here (the
+     *        material law parameters and MatrixPermeability).
+     *
+     * \param stage The stage index (0 for Stage.1)
+     * \param name The parameter name, e.g. MatrixLambda
+     */
+    Scalar stageValue(int stage, const std::string& name) const
+    { return this->getFromStage(stage, episodeValueKey_(name)); }
+
+    /*!
+     * \brief Change an input value of a stage (see stageValue()), the
+     *        material law parameters of the current episode are set up
+     *        again.
+     *
+     * Used to perturb the parameters for sensitivities, the volume
+     * variables have to be updated by the caller.
+     */
+    void setStageValue(int stage, const std::string& name, Scalar value)
+    {
+        LswiData<TypeTag>::setStageValue(stage, episodeValueKey_(name), value);
+        setEpisodeMaterialParams_();
+    }
+
+    template<class FS>
+    int wettingPhaseAtPos(const GlobalPosition& globalPos) const
+    {
+      return FS::phase0Idx;
+    }
+
+private:
+    // Set the high and low salinity parameters of episode i. Episodes
+    // are entered in order, the high salinity values are reset to the
+    // low salinity values of the previous stage whenever the input
+    // salinity changes.
+    void updateEpisodeParams_(int i)
+    {
+        if (i == episode_) return;
+        episode_ = i;
+        DBG("***---   SpatialParams at episode %d, stage=%d\n", 
+                i, this->stageNumber(i));
+
+        if (this->useBCM_){
+            setEpisodeMaterialParams_();
+            return;
+        }
+
+        // Interpolate between high and low values
+        //
+        // If input salinity has not changed, keep 
+        // going with the initial values.
+
+        // High value will be either initial values
+        // on the first episode or the values of 
+        // the previous when an input salinity change
+        // is specified.
+        //
+        if (lastInputSalinity_ < 0) {
+            lastInputSalinity_ = this->xParticleTotal(i);
+        }
+        auto inputSalinity = this->xParticleTotal(i);
+        if (inputSalinity != lastInputSalinity_) {
+            // Reset last input salinity.
+            DBG("reset input salinity.. %le --> %le\n", lastInputSalinity_,inputSalinity);
+            lastInputSalinity_ = inputSalinity;
+
+            // Since salinity has changed, reset HS values to the 
+            // LS values of the previous stage.
+            //
+            highSalinityStage_ = this->stageNumber(i)-1; // previous stage
+            DBG("MatrixSnr=%lf MatrixKrnMax=%lf\n",this->getFromStage(highSalinityStage_, "MatrixSnr"),
+                this->getFromStage(highSalinityStage_, "MatrixKrnMax"));
+        }
+        setEpisodeMaterialParams_();
+        this->dump();
+    }
+
+    // The parameter id of the input values read by get(episode_, ...)
+    // (the parameter map compares the ids of lswiScalars, not the strings).
+    static const char *episodeValueKey_(const std::string& name)
+    {
+        static const char *episodeValues[] = {
+            "MatrixPermeability", "MatrixLambda", "MatrixKrwMax", "MatrixSwr", "Matrixnw",
+            "MatrixPe", "Matrixnn", "MatrixKrnMax", "MatrixSnr"
+        };
+        for (auto value : episodeValues) {
+            if (name != value) continue;
+            for (auto p=lswiScalars; *p; p++)
+                if (name == *p) return *p;
+        }
+        DUNE_THROW(Dumux::ParameterException, name << " is not a material law parameter or MatrixPermeability");
+    }
+
+    // Material law parameters of the current episode from the input
+    // values (see updateEpisodeParams_()).
+    void setEpisodeMaterialParams_()
+    {
+        const int i = episode_;
 
         // Low salinity: use input current values for
         // both BCM and BCMV.
         //
-        if (episodeSwitch){
-            materialParams_.setPe_LS(this->get(i, "MatrixPe"));
-            materialParams_.setLambda_LS(this->get(i, "MatrixLambda"));
-            materialParams_.setK0rw_LS(this->get(i, "MatrixKrwMax"));
-            materialParams_.setK0rn_LS(this->get(i, "MatrixKrnMax"));
-            materialParams_.setNw_LS(this->get(i, "Matrixnw"));
-            materialParams_.setNn_LS(this->get(i, "Matrixnn"));
-            materialParams_.setSwr_LS(this->get(i, "MatrixSwr"));
-            materialParams_.setSnr_LS(this->get(i, "MatrixSnr"));
-
-            //  Salinity set from single particle (Particle.1)
-            //        Here we should change salinity for ionic
-            //        strength in chemical model.
-            materialParams_.setLS(this->xParticleTotal(i));
-        } 
-
-        
-            
+        materialParams_.setPe_LS(this->get(i, "MatrixPe"));
+        materialParams_.setLambda_LS(this->get(i, "MatrixLambda"));
+        materialParams_.setK0rw_LS(this->get(i, "MatrixKrwMax"));
+        materialParams_.setK0rn_LS(this->get(i, "MatrixKrnMax"));
+        materialParams_.setNw_LS(this->get(i, "Matrixnw"));
+        materialParams_.setNn_LS(this->get(i, "Matrixnn"));
+        materialParams_.setSwr_LS(this->get(i, "MatrixSwr"));
+        materialParams_.setSnr_LS(this->get(i, "MatrixSnr"));
+
+        //  Salinity set from single particle (Particle.1)
+        //        Here we should change salinity for ionic
+        //        strength in chemical model.
+        materialParams_.setLS(this->xParticleTotal(i));
+
         // High Salinity
         if (this->useBCM_){
             // No interpolation here
@@ -231,89 +403,47 @@ public:
             materialParams_.setHS(this->xParticleTotal(i));
             // Salinity is set to input current value.
             materialParams_.setS(this->xParticleTotal(i));
-            return materialParams_;
-        }
-        
-
-       // Interpolate between high and low values
-       //
-       // If input salinity has not changed, keep 
-       // going with the initial values.
-        
-
-        // High value will be either initial values
-        // on the first episode or the values of 
-        // the previous when an input salinity change
-        // is specified.
-        //
-        if (episodeSwitch){
-            int thisStage;
-            static Scalar lastInputSalinity = -1;
-            if (lastInputSalinity < 0) {
-                lastInputSalinity = this->xParticleTotal(episode);
-            }
-            auto inputSalinity = this->xParticleTotal(episode);
-            if (inputSalinity != lastInputSalinity) {
-                // Reset last input salinity.
-                DBG("***************************\n*********************\n");
-                DBG("reset input salinity.. %le --> %le\n", lastInputSalinity,inputSalinity);
-                lastInputSalinity = inputSalinity;
-
-                // Since salinity has changed, reset HS values to the 
-                // LS values of the previous stage.
-                //
-                thisStage = this->stageNumber(episode);// this stage.
-                int j = thisStage-1; // previous stage
-                materialParams_.setPe_HS(this->getFromStage(j, "MatrixPe"));
-                materialParams_.setLambda_HS(this->getFromStage(j, "MatrixLambda"));
-                materialParams_.setK0rw_HS(this->getFromStage(j, "MatrixKrwMax"));
-                materialParams_.setK0rn_HS(this->getFromStage(j, "MatrixKrnMax"));
-                materialParams_.setNw_HS(this->getFromStage(j, "Matrixnw"));
-                materialParams_.setNn_HS(this->getFromStage(j, "Matrixnn"));
-                materialParams_.setSwr_HS(this->getFromStage(j, "MatrixSwr"));
-                materialParams_.setSnr_HS(this->getFromStage(j, "MatrixSnr"));
-
-                DBG("MatrixSnr=%lf MatrixKrnMax=%lf\n",this->getFromStage(j, "MatrixSnr"),
-                    this->getFromStage(j, "MatrixKrnMax"));
-
-                materialParams_.setHS(this->xParticleTotalFromStageNumber(j));           
-            }
-        }
-        
-
-        // Salinity is set to solution salinity value at element.
-        // Case with single particle (NaCl): XXX.
-        /*static constexpr int NaClIdx = FluidSystem::comp0Idx+1;
-        const auto salinity = elemSol[scv.indexInElement()][NaClIdx];//XXX
-        materialParams_.setS(salinity);
-        TRACE("high=%le, low=%le, current=%le\n", 
-                this->getValue("xNa"), this->get(i, "xNa"), salinity);*/
-       
-        Scalar totalSalinity = 0.0;      
-        for (int compIdx = 1; compIdx < FluidSystem::numComponents-1; ++compIdx)
-        {
-            totalSalinity += elemSol[scv.indexInElement()][compIdx];
+            materialParams_.setSalinityMode(SalinityMode::constant);
+            return;
         }
-        materialParams_.setS(totalSalinity);
-
 
-        if (episodeSwitch) 
-        {
-            DBG("*** salinity = %le, totalSalinity = %le\n", 
-                    elemSol[scv.indexInElement()][1], totalSalinity);
-            this->dump();
+        // Until the first salinity change the high salinity values
+        // are the initial values (as in the constructor).
+        if (highSalinityStage_ < 0) {
+            materialParams_.setPe_HS(this->getValue("MatrixPe"));
+            materialParams_.setLambda_HS(this->getValue("MatrixLambda"));
+            materialParams_.setK0rw_HS(this->getValue("MatrixKrwMax"));
+            materialParams_.setK0rn_HS(this->getValue("MatrixKrnMax"));
+            materialParams_.setNw_HS(this->getValue("Matrixnw"));
+            materialParams_.setNn_HS(this->getValue("Matrixnn"));
+            materialParams_.setSwr_HS(this->getValue("MatrixSwr"));
+            materialParams_.setSnr_HS(this->getValue("MatrixSnr"));
+            materialParams_.setHS(this->xParticleInitialTotal());
+        } else {
+            const int j = highSalinityStage_;
+            materialParams_.setPe_HS(this->getFromStage(j, "MatrixPe"));
+            materialParams_.setLambda_HS(this->getFromStage(j, "MatrixLambda"));
+            materialParams_.setK0rw_HS(this->getFromStage(j, "MatrixKrwMax"));
+            materialParams_.setK0rn_HS(this->getFromStage(j, "MatrixKrnMax"));
+            materialParams_.setNw_HS(this->getFromStage(j, "Matrixnw"));
+            materialParams_.setNn_HS(this->getFromStage(j, "Matrixnn"));
+            materialParams_.setSwr_HS(this->getFromStage(j, "MatrixSwr"));
+            materialParams_.setSnr_HS(this->getFromStage(j, "MatrixSnr"));
+            materialParams_.setHS(this->xParticleTotalFromStageNumber(j));           
         }
-        return materialParams_;
-   }
-
-    template<class FS>
-    int wettingPhaseAtPos(const GlobalPosition& globalPos) const
-    {
-      return FS::phase0Idx;
+        // Without a salinity change there is nothing to interpolate,
+        // the material law may skip the low salinity curves.
+        materialParams_.setSalinityMode((materialParams_.LS() == materialParams_.HS())?
+                                        SalinityMode::constant : SalinityMode::interpolated);
     }
 
-private:
-    mutable MaterialLawParams materialParams_;
+    // parameters of the current episode, the salinity S is set per scv
+    MaterialLawParams materialParams_;
+    Scalar lastInputSalinity_;
+    int highSalinityStage_; // stage of the high salinity values, -1: initial values
+    Scalar porosity_;
+    Scalar brineDensity_;   // of the episode, <= 0: fluid system default
+    Scalar brineViscosity_;
 
 };
 
@@ -0,0 +1,159 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+/*!
+ * \file
+ *
+ * \brief Test of the reactive couplings of the chemistry step: over one
+ *        short step the operator splitting (ChemistryStep::apply(),
+ *        Chemistry.Coupling = Split) and the reactive source
+ *        (ChemistryStep::rates() times dt, Chemistry.Coupling = Source)
+ *        change the particle mole fractions alike. Built with SOLVE_ODES,
+ *        apply() integrates the kinetics over the step.
+ */
+#include <config.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/parametertree.hh>
+#include <dune/istl/bvector.hh>
+
+#include <dumux/common/parameters.hh>
+#include <dumux/common/properties.hh>
+
+#include "dumux/porousmediumflow/2pncimmiscible/chemistrystep.hh"
+
+namespace Dumux {
+
+// The brine of the chemistry: pressure, saturation and one particle per
+// transported ion of the chemical model.
+static const char *testIons[] = {"Na+", "Ca++", "Mg++", "Cl-", "SO4--", "HCO3-", "H+"};
+static const int numTestParticles = 7;
+
+class ChemistryTestProblem
+{
+public:
+    double temperature() const { return 273.15 + 80.0; }
+    int numParticles() const { return numTestParticles; }
+    std::string particleIdx(int particle) const { return testIons[particle]; }
+};
+
+struct ChemistryTestFluidSystem
+{
+    static constexpr int comp0Idx = 1;
+};
+
+namespace Properties {
+namespace TTag {
+struct ChemistryTest {};
+} // end namespace TTag
+
+template<class TypeTag>
+struct Scalar<TypeTag, TTag::ChemistryTest> { using type = double; };
+template<class TypeTag>
+struct Problem<TypeTag, TTag::ChemistryTest> { using type = ChemistryTestProblem; };
+template<class TypeTag>
+struct FluidSystem<TypeTag, TTag::ChemistryTest> { using type = ChemistryTestFluidSystem; };
+template<class TypeTag>
+struct PrimaryVariables<TypeTag, TTag::ChemistryTest> { using type = Dune::FieldVector<double, 2 + numTestParticles>; };
+template<class TypeTag>
+struct SolutionVector<TypeTag, TTag::ChemistryTest> { using type = Dune::BlockVector<Dune::FieldVector<double, 2 + numTestParticles>>; };
+} // end namespace Properties
+} // end namespace Dumux
+
+int main(int argc, char** argv) try
+{
+    using namespace Dumux;
+    using TypeTag = Properties::TTag::ChemistryTest;
+    using SolutionVector = GetPropType<TypeTag, Properties::SolutionVector>;
+    using PrimaryVariables = GetPropType<TypeTag, Properties::PrimaryVariables>;
+
+    Dune::MPIHelper::instance(argc, argv);
+    Parameters::init([](Dune::ParameterTree& params){
+        params["Chemistry.Threads"] = "1";
+        params["Chemistry.K1A"] = "1e-4";
+        params["Chemistry.K1B"] = "1e-4";
+        params["Chemistry.K1C"] = "1e-4";
+    });
+
+    // cells of different composition (mole fractions of the brine)
+    const int numCells = 16;
+    const double moleFractions[numTestParticles] = {1e-2, 1e-3, 1e-3, 1e-2, 5e-4, 1e-3, 1e-8};
+    SolutionVector x(numCells);
+    for (int cellIdx = 0; cellIdx < numCells; cellIdx++) {
+        x[cellIdx][0] = 1e7;
+        x[cellIdx][1] = 0.5;
+        for (int particle = 0; particle < numTestParticles; particle++)
+            x[cellIdx][2 + particle] = moleFractions[particle] * (1.0 + 0.1*cellIdx*(particle + 1)/numTestParticles);
+    }
+
+    ChemistryTestProblem problem;
+    ChemistryStep<TypeTag> chemistryStep(problem);
+    chemistryStep.setBrineDensity(1130.0);
+
+    // A step short enough for the rates to be constant over it. The
+    // change of apply() is the difference of the mole fractions before
+    // and after, which carries their round-off (1e-16*1e-2/1e-12).
+    const double dt = 1e-5;
+#ifdef SOLVE_ODES
+    const double tolerance = 1e-3;
+#else
+    const double tolerance = 1e-5;
+#endif
+
+    std::vector<PrimaryVariables> rates;
+    chemistryStep.rates(x, rates);
+    SolutionVector y(x);
+    chemistryStep.apply(y, dt);
+
+    double maxChange = 0.0;
+    double maxDeviation = 0.0;
+    for (int cellIdx = 0; cellIdx < numCells; cellIdx++) {
+        for (int particle = 0; particle < numTestParticles; particle++) {
+            const int pvIdx = 2 + particle;
+            const double split = y[cellIdx][pvIdx] - x[cellIdx][pvIdx];
+            const double source = rates[cellIdx][pvIdx] * dt;
+            const double scale = std::max(std::abs(split), std::abs(source));
+            maxChange = std::max(maxChange, scale);
+            if (scale > 0)
+                maxDeviation = std::max(maxDeviation, std::abs(split - source) / scale);
+        }
+    }
+    std::cout << "largest change " << maxChange << ", largest relative deviation "
+              << maxDeviation << " (tolerance " << tolerance << ")" << std::endl;
+
+    if (!(maxChange > 0))
+        DUNE_THROW(Dune::InvalidStateException, "The particles do not react");
+    if (!(maxDeviation <= tolerance))
+        DUNE_THROW(Dune::InvalidStateException, "Split and Source couplings change the particles differently");
+
+    return 0;
+}
+catch (const Dune::Exception& e)
+{
+    std::cerr << "Dune reported error: " << e << std::endl;
+    return 1;
+}
@@ -0,0 +1,128 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*****************************************************************************
+ *   See the file COPYING for full copying permissions.                      *
+ *                                                                           *
+ *   This program is free software: you can redistribute it and/or modify    *
+ *   it under the terms of the GNU General Public License as published by    *
+ *   the Free Software Foundation, either version 2 of the License, or       *
+ *   (at your option) any later version.                                     *
+ *                                                                           *
+ *   This program is distributed in the hope that it will be useful,         *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of          *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the            *
+ *   GNU General Public License for more details.                            *
+ *                                                                           *
+ *   You should have received a copy of the GNU General Public License       *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ *****************************************************************************/
+/*!
+ * \file
+ *
+ * \brief Test of the threaded speciation: the same cells speciated
+ *        serially and through the ThreadPool, with one Ions::Context per
+ *        thread as in ChemistryStep, give bitwise identical results.
+ */
+#include <config.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/parallel/mpihelper.hh>
+
+#include "dumux/parallel/threadpool.hh"
+#include "dumux/material/fluidsystems/ions.hh"
+
+namespace Dumux {
+
+using TestIons = Ions<double>;
+
+// Base molalities [mol/kg] of the transported ions of the network.
+double baseMolality(const std::string& name)
+{
+    if (name == "Na+") return 0.5;
+    if (name == "Ca++") return 0.05;
+    if (name == "Mg++") return 0.05;
+    if (name == "Cl-") return 0.6;
+    if (name == "SO4--") return 0.02;
+    if (name == "HCO3-") return 0.05;
+    if (name == "H+") return 1e-6;
+    return 0.0;
+}
+
+// Speciate one cell, the composition varies with the cell index.
+void speciate(int cellIdx, double dt, TestIons::Context *ctx,
+              chemicalModel_t& cm, speciationStatus_t& status)
+{
+    cm = chemicalModel_t();
+    for (int compIdx = TestIons::numPhases; compIdx < TestIons::numComponents; compIdx++)
+        cm.molalities[compIdx] = baseMolality(TestIons::name(compIdx))
+                                 * (1.0 + 0.5*((cellIdx*(compIdx + 3)) % 17)/17.0);
+    status = {true, 0, 0, 0.0, 0, 0};
+    TestIons::ionicStrength(dt, &cm, ctx, &status);
+}
+
+bool sameStatus(const speciationStatus_t& a, const speciationStatus_t& b)
+{
+    return a.converged == b.converged && a.iterations == b.iterations
+           && a.outerIterations == b.outerIterations && a.odeSubsteps == b.odeSubsteps
+           && a.odeRejected == b.odeRejected
+           && std::memcmp(&a.residual, &b.residual, sizeof(a.residual)) == 0
+           && std::memcmp(a.kineticChange, b.kineticChange, sizeof(a.kineticChange)) == 0;
+}
+
+} // end namespace Dumux
+
+int main(int argc, char** argv) try
+{
+    using namespace Dumux;
+
+    Dune::MPIHelper::instance(argc, argv);
+
+    TestIons::Context ctx = TestIons::makeContext(273.15 + 80.0);
+    TestIons::setBrineDensity(&ctx, 1130.0);
+    TestIons::setK1A(&ctx, 1e-4);
+    TestIons::setK1B(&ctx, 1e-4);
+    TestIons::setK1C(&ctx, 1e-4);
+
+    const int numCells = 1000;
+    const double dt = 10.0;
+
+    // serial reference, one context for all cells
+    std::vector<chemicalModel_t> serial(numCells);
+    std::vector<speciationStatus_t> serialStatus(numCells);
+    TestIons::Context serialCtx = ctx;
+    for (int cellIdx = 0; cellIdx < numCells; cellIdx++)
+        speciate(cellIdx, dt, &serialCtx, serial[cellIdx], serialStatus[cellIdx]);
+
+    // threads with their own context, small grain so that work is stolen
+    for (int numThreads : {2, 4, 8}) {
+        ThreadPool pool(numThreads);
+        std::vector<TestIons::Context> contexts(pool.size(), ctx);
+        std::vector<chemicalModel_t> threaded(numCells);
+        std::vector<speciationStatus_t> threadedStatus(numCells);
+        pool.parallelFor(numCells, [&](std::size_t cellIdx, int threadIdx){
+            speciate(cellIdx, dt, &contexts[threadIdx], threaded[cellIdx], threadedStatus[cellIdx]);
+        }, 3);
+
+        int differences = 0;
+        for (int cellIdx = 0; cellIdx < numCells; cellIdx++)
+            if (std::memcmp(&serial[cellIdx], &threaded[cellIdx], sizeof(chemicalModel_t)) != 0
+                || !sameStatus(serialStatus[cellIdx], threadedStatus[cellIdx]))
+                differences++;
+        std::cout << numThreads << " threads: " << differences << " of "
+                  << numCells << " cells differ from the serial speciation" << std::endl;
+        if (differences > 0)
+            DUNE_THROW(Dune::InvalidStateException, "Threaded speciation differs from the serial one");
+    }
+
+    return 0;
+}
+catch (const Dune::Exception& e)
+{
+    std::cerr << "Dune reported error: " << e << std::endl;
+    return 1;
+}